@@ -0,0 +1,421 @@
+#include "json.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+//benchmarks parse, stringify, access and copy over a set of standard corpora.
+//usage: jasoon_bench [--reps N] [--warmup N] [--data DIR] [corpus-filter]
+//twitter.json and canada.json are used from DIR when present, otherwise generated.
+
+using namespace jasoon;
+using namespace std::chrono;
+
+//kept out of line: once inlined, gcc pairs malloc with operator delete and warns of a mismatch
+#if defined(__GNUC__)
+#define NOINLINE [[gnu::noinline]]
+#else
+#define NOINLINE
+#endif
+
+static std::atomic<size_t> allocations{ 0 }; //every operator new of the process
+
+NOINLINE void* operator new(size_t n)
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	if (void* p = std::malloc(n))
+		return p;
+	throw std::bad_alloc();
+}
+
+NOINLINE void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+NOINLINE void operator delete(void* p, size_t) noexcept
+{
+	std::free(p);
+}
+
+static size_t blackhole = 0; //results are folded in here so nothing is optimized away
+
+struct Options
+{
+	int reps = 10;
+	int warmup = 2;
+	std::string data_dir = JASOON_DATA_DIR;
+	std::string filter;
+};
+
+struct Corpus
+{
+	std::string name;
+	std::string text;
+	std::function<size_t(const Json&)> access; //reads a fixed set of values through const operator[]
+	std::vector<std::string_view> paths; //what access reads, for the projected parse
+};
+
+struct Result
+{
+	double median_ms;
+	double mb_per_s;
+	double allocations;
+};
+
+template<typename F>
+Result measure(const Options& options, size_t bytes, F&& f)
+{
+	for (int i = 0; i < options.warmup; ++i)
+		f();
+	std::vector<double> times;
+	size_t allocated = 0;
+	for (int i = 0; i < options.reps; ++i)
+	{
+		const auto before = allocations.load();
+		const auto start = steady_clock::now();
+		f();
+		const auto end = steady_clock::now();
+		allocated += allocations.load() - before;
+		times.push_back(duration<double, std::milli>(end - start).count());
+	}
+	std::sort(times.begin(), times.end());
+	const auto median = times[times.size() / 2];
+	return { median, bytes / 1e6 / (median / 1e3), static_cast<double>(allocated) / options.reps };
+}
+
+void report(const std::string& corpus, const std::string& op, const Result& r)
+{
+	std::printf("%-16s %-22s %10.3f %10.1f %12.0f\n",
+		corpus.c_str(), op.c_str(), r.median_ms, r.mb_per_s, r.allocations);
+}
+
+bool readFile(const std::string& path, std::string& s)
+{
+	std::ifstream f(path, std::ios::binary);
+	if (!f)
+		return false;
+	s.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+	return true;
+}
+
+std::string number(double d)
+{
+	char buffer[32];
+	std::snprintf(buffer, sizeof(buffer), "%.15g", d);
+	return buffer;
+}
+
+std::string makeTwitter() //same shape as twitter.json: status objects with nested users
+{
+	std::string s = "{\"statuses\": [";
+	for (int i = 0; i < 400; ++i)
+	{
+		const auto id = std::to_string(505874924095815680LL + i);
+		if (i)
+			s += ',';
+		s += "{\"metadata\": {\"result_type\": \"recent\", \"iso_language_code\": \"ja\"},"
+			"\"created_at\": \"Sun Aug 31 00:29:15 +0000 2014\", \"id\": " + id + ", \"id_str\": \"" + id + "\","
+			"\"text\": \"@aym0566x \\u540d\\u524d:\\u524d\\u7530\\u3042\\u3086\\u307f retweet #" + std::to_string(i) + "\","
+			"\"source\": \"<a href=\\\"http://twitter.com/download/iphone\\\" rel=\\\"nofollow\\\">Twitter for iPhone</a>\","
+			"\"truncated\": false, \"in_reply_to_status_id\": null, \"in_reply_to_user_id\": 866260188,"
+			"\"user\": {\"id\": " + std::to_string(1186275104 + i) + ", \"name\": \"AYUMI\", \"screen_name\": \"ayuu0123_" + std::to_string(i) + "\","
+			"\"location\": \"\", \"description\": \"\\u5143\\u91ce\\u7403\\u90e8\\u30de\\u30cd\\u30fc\\u30b8\\u30e3\\u30fc\","
+			"\"url\": null, \"protected\": false, \"followers_count\": 262, \"friends_count\": 252, \"listed_count\": 0,"
+			"\"created_at\": \"Mon Feb 18 18:02:58 +0000 2013\", \"favourites_count\": 235, \"utc_offset\": null,"
+			"\"verified\": false, \"statuses_count\": 1769, \"lang\": \"en\", \"profile_background_color\": \"C0DEED\","
+			"\"profile_image_url\": \"http://pbs.twimg.com/profile_images/497760886795153410/LDjAwR_y_normal.jpeg\","
+			"\"default_profile\": true, \"following\": false},"
+			"\"geo\": null, \"coordinates\": null, \"place\": null, \"contributors\": null,"
+			"\"retweet_count\": " + std::to_string(i % 7) + ", \"favorite_count\": 0,"
+			"\"entities\": {\"hashtags\": [], \"symbols\": [], \"urls\": [],"
+			"\"user_mentions\": [{\"screen_name\": \"aym0566x\", \"name\": \"\\u524d\\u7530\\u3042\\u3086\\u307f\","
+			"\"id\": 866260188, \"id_str\": \"866260188\", \"indices\": [0, 9]}]},"
+			"\"favorited\": false, \"retweeted\": false, \"lang\": \"ja\"}";
+	}
+	s += "], \"search_metadata\": {\"completed_in\": 0.087, \"max_id\": 505874924095815681,"
+		"\"query\": \"%E4%B8%80\", \"count\": 100, \"since_id\": 0}}";
+	return s;
+}
+
+std::string makeCanada() //same shape as canada.json: one polygon of many coordinate pairs
+{
+	std::string s = "{\"type\": \"FeatureCollection\", \"features\": [{\"type\": \"Feature\","
+		"\"properties\": {\"name\": \"Canada\"}, \"geometry\": {\"type\": \"Polygon\", \"coordinates\": [";
+	std::uint64_t seed = 88172645463325252ULL;
+	for (int ring = 0; ring < 480; ++ring)
+	{
+		if (ring)
+			s += ',';
+		s += '[';
+		for (int point = 0; point < 116; ++point)
+		{
+			seed ^= seed << 13;
+			seed ^= seed >> 7;
+			seed ^= seed << 17;
+			if (point)
+				s += ',';
+			s += '[' + number(-141.0 + (seed % 8000000) / 100000.0 + 1e-9 * (seed % 997))
+				+ ',' + number(41.0 + (seed % 4200000) / 100000.0 + 1e-9 * (seed % 991)) + ']';
+		}
+		s += ']';
+	}
+	s += "]}}]}";
+	return s;
+}
+
+std::string makeDeepNesting() //alternating arrays and objects, 500 levels deep
+{
+	std::string s = "[";
+	for (int i = 0; i < 100; ++i)
+	{
+		if (i)
+			s += ',';
+		for (int d = 0; d < 500; ++d)
+			s += d % 2 ? "{\"a\": " : "[";
+		s += std::to_string(i);
+		for (int d = 499; d >= 0; --d)
+			s += d % 2 ? "}" : "]";
+	}
+	s += ']';
+	return s;
+}
+
+std::string makeTelemetry() //telemetry-like: large arrays of only floats or only integers
+{
+	std::string s = "{\"samples\": [";
+	std::uint64_t seed = 2463534242ULL;
+	for (int series = 0; series < 32; ++series)
+	{
+		if (series)
+			s += ',';
+		s += '[';
+		for (int i = 0; i < 4096; ++i)
+		{
+			seed ^= seed << 13;
+			seed ^= seed >> 7;
+			seed ^= seed << 17;
+			if (i)
+				s += ',';
+			s += series % 2 ? std::to_string(seed % 100000) : number((seed % 1000000) / 1000.0 + 0.5);
+		}
+		s += ']';
+	}
+	s += "]}";
+	return s;
+}
+
+std::string makeLongStrings() //a few large string values
+{
+	std::string s = "[";
+	for (int i = 0; i < 64; ++i)
+	{
+		if (i)
+			s += ',';
+		s += '"';
+		for (int j = 0; j < 64 * 1024; ++j)
+			s += static_cast<char>('a' + (i + j) % 26);
+		s += '"';
+	}
+	s += ']';
+	return s;
+}
+
+std::vector<Corpus> loadCorpora(const Options& options)
+{
+	std::vector<Corpus> corpora;
+	Corpus citm{ "citm_catalog", "", [](const Json& j)
+	{
+		size_t sum = 0;
+		auto& performances = j["performances"];
+		for (size_t i = 0; i < performances.size(); ++i)
+		{
+			sum += static_cast<Json::interger_t>(performances[i]["id"]);
+			sum += performances[i]["seatCategories"].size();
+		}
+		return sum;
+	}, { "performances[*].id", "performances[*].seatCategories" } };
+	if (!readFile(options.data_dir + "/citm_catalog.json", citm.text))
+		std::fprintf(stderr, "citm_catalog.json not found in %s\n", options.data_dir.c_str());
+	else
+		corpora.push_back(std::move(citm));
+
+	Corpus twitter{ "twitter", "", [](const Json& j)
+	{
+		size_t sum = 0;
+		auto& statuses = j["statuses"];
+		for (size_t i = 0; i < statuses.size(); ++i)
+		{
+			const std::string name = statuses[i]["user"]["screen_name"];
+			sum += name.size() + static_cast<Json::interger_t>(statuses[i]["retweet_count"]);
+		}
+		return sum;
+	}, { "statuses[*].user.screen_name", "statuses[*].retweet_count" } };
+	if (!readFile(options.data_dir + "/twitter.json", twitter.text))
+		twitter.text = makeTwitter();
+	corpora.push_back(std::move(twitter));
+
+	Corpus canada{ "canada", "", [](const Json& j)
+	{
+		double sum = 0;
+		auto& rings = j["features"][0]["geometry"]["coordinates"];
+		for (size_t r = 0; r < rings.size(); ++r)
+		{
+			auto& ring = rings[r];
+			for (size_t p = 0; p < ring.size(); ++p)
+				sum += static_cast<double>(ring[p][0]) + static_cast<double>(ring[p][1]);
+		}
+		return static_cast<size_t>(sum);
+	}, {} };
+	if (!readFile(options.data_dir + "/canada.json", canada.text))
+		canada.text = makeCanada();
+	corpora.push_back(std::move(canada));
+
+	corpora.push_back({ "deep_nesting", makeDeepNesting(), [](const Json& j)
+	{
+		size_t sum = 0;
+		for (size_t i = 0; i < j.size(); ++i)
+		{
+			const Json* node = &j[i];
+			for (int d = 0; d < 500; ++d)
+				node = d % 2 ? &(*node)["a"] : &(*node)[0];
+			sum += static_cast<Json::interger_t>(*node);
+		}
+		return sum;
+	}, {} });
+
+	corpora.push_back({ "telemetry", makeTelemetry(), [](const Json& j)
+	{
+		double sum = 0;
+		auto& samples = j["samples"];
+		for (size_t i = 0; i < samples.size(); ++i)
+		{
+			for (const auto f : samples[i].packed<double>())
+				sum += f;
+			for (const auto n : samples[i].packed<Json::interger_t>())
+				sum += static_cast<double>(n);
+		}
+		return static_cast<size_t>(sum);
+	}, {} });
+
+	corpora.push_back({ "long_strings", makeLongStrings(), [](const Json& j)
+	{
+		size_t sum = 0;
+		for (size_t i = 0; i < j.size(); ++i)
+		{
+			const std::string s = j[i];
+			sum += s.size();
+		}
+		return sum;
+	}, {} });
+	return corpora;
+}
+
+void benchCorpus(const Options& options, const Corpus& corpus)
+{
+	const auto bytes = corpus.text.size();
+	report(corpus.name, "parse", measure(options, bytes, [&]
+	{
+		blackhole += Json::parse(corpus.text).size();
+	}));
+
+	Json::Parser parser;
+	Json::Document doc;
+	report(corpus.name, "parse (document)", measure(options, bytes, [&]
+	{
+		parser.parse(corpus.text, doc);
+		blackhole += doc.root().size();
+	}));
+
+	if (!corpus.paths.empty())
+	{
+		const Json::Projection projection(corpus.paths.begin(), corpus.paths.end());
+		report(corpus.name, "parse (projection)", measure(options, bytes, [&]
+		{
+			auto projected = parser.parse(corpus.text, projection);
+			blackhole += corpus.access(projected);
+		}));
+	}
+
+	auto j = Json::parse(corpus.text);
+	const auto text = j.stringify();
+	report(corpus.name, "stringify", measure(options, text.size(), [&]
+	{
+		blackhole += j.stringify().size();
+	}));
+
+	report(corpus.name, "access", measure(options, bytes, [&]
+	{
+		blackhole += corpus.access(j);
+	}));
+
+	report(corpus.name, "copy", measure(options, bytes, [&]
+	{
+		Json copy = j;
+		blackhole += copy.size();
+	}));
+}
+
+void benchScaling(const Options& options, const Corpus& corpus) //parallel paths at 1, 2, 4... threads
+{
+	std::string text = "[";
+	for (int i = 0; i < 16; ++i)
+	{
+		if (i)
+			text += ',';
+		text += corpus.text;
+	}
+	text += ']';
+	const auto j = Json::parse(text);
+	const auto serial = j.stringify();
+	const auto cores = std::max(1u, std::thread::hardware_concurrency());
+	for (unsigned threads = 1; ; threads = std::min(threads * 2, cores))
+	{
+		Thread_pool pool(threads);
+		const auto suffix = " x" + std::to_string(threads);
+		report(corpus.name + "x16", "parse_parallel" + suffix, measure(options, text.size(), [&]
+		{
+			blackhole += Json::parse_parallel(text, pool).size();
+		}));
+		report(corpus.name + "x16", "stringify_parallel" + suffix, measure(options, serial.size(), [&]
+		{
+			blackhole += j.stringify_parallel(pool).size();
+		}));
+		if (threads == cores)
+			break;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Options options;
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string arg = argv[i];
+		if (arg == "--reps" && i + 1 < argc)
+			options.reps = std::max(1, std::atoi(argv[++i]));
+		else if (arg == "--warmup" && i + 1 < argc)
+			options.warmup = std::max(0, std::atoi(argv[++i]));
+		else if (arg == "--data" && i + 1 < argc)
+			options.data_dir = argv[++i];
+		else
+			options.filter = arg;
+	}
+
+	const auto corpora = loadCorpora(options);
+	std::printf("%-16s %-22s %10s %10s %12s\n", "corpus", "op", "median ms", "MB/s", "allocs/op");
+	for (const auto& corpus : corpora)
+	{
+		if (corpus.name.find(options.filter) == std::string::npos)
+			continue;
+		benchCorpus(options, corpus);
+	}
+	for (const auto& corpus : corpora)
+	{
+		if (corpus.name == "citm_catalog" && corpus.name.find(options.filter) != std::string::npos)
+			benchScaling(options, corpus);
+	}
+	std::fprintf(stderr, "checksum %zu\n", blackhole);
+	return 0;
+}
@@ -1,6 +1,7 @@
 #pragma once
 #include <variant>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <string>
 #include <memory>
@@ -16,6 +17,34 @@
 #include <stdexcept>
 #include <functional>
 #include <array>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <chrono>
+#include <charconv>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include <limits>
+#include <span>
+#include <bit>
+#include <optional>
+#include <coroutine>
 
 namespace jasoon
 {
@@ -26,10 +55,129 @@ namespace jasoon
 		using std::logic_error::logic_error;
 	};
 
+	enum class Parse_errc
+	{
+		None,
+		Unexpected_character,
+		Unterminated_string,
+		Invalid_number,
+		Invalid_literal,
+		Value_expected,
+		Name_expected,
+		Name_separator_expected, //':'
+		Object_end_expected,     //'}' or ','
+		Array_end_expected,      //']' or ','
+		Root_expected,           //an array or object
+		Trailing_characters,
+		Nesting_too_deep,
+		Document_too_large,
+		String_too_long,
+		Too_many_elements,
+		Cannot_open_file,
+		Schema_mismatch //see Parser::schema_error()
+	};
+
+	inline const char* error_message(Parse_errc code) noexcept
+	{
+		static constexpr const char* messages[] = {
+			"no error", "unexpected character", "unterminated string", "invalid number",
+			"invalid literal", "value is expected", "name is expected", "':' is expected",
+			"'}' is expected", "']' is expected", "must be started with array or object",
+			"unexpected character after the document", "nesting is too deep", "document is too large",
+			"string is too long", "too many elements", "cannot open file",
+			"value does not match the schema" };
+		return messages[static_cast<size_t>(code)];
+	}
+
+	//where and why a text parse failed. line and column (1-based) are worked out from the
+	//offset only once a parse has failed, so reading the input never counts lines
+	struct Parse_error
+	{
+		Parse_errc code = Parse_errc::None;
+		size_t offset = 0; //bytes into the input
+		size_t line = 0;   //0 when the error has no position, e.g. a file that cannot be opened
+		size_t column = 0;
+
+		static Parse_error at(std::string_view input, Parse_errc code, size_t offset) noexcept
+		{
+			const auto before = input.substr(0, offset);
+			const auto last_newline = before.rfind('\n');
+			return { code, offset, static_cast<size_t>(std::count(before.begin(), before.end(), '\n')) + 1,
+				last_newline == std::string_view::npos ? offset + 1 : offset - last_newline };
+		}
+
+		explicit operator bool() const noexcept //true on failure
+		{
+			return code != Parse_errc::None;
+		}
+
+		const char* message() const noexcept
+		{
+			return error_message(code);
+		}
+	};
+
+	enum class Schema_errc
+	{
+		None,
+		Type,
+		Enum,
+		Required,
+		Minimum,
+		Maximum,
+		Min_length,
+		Max_length,
+		Min_items,
+		Max_items
+	};
+
+	inline const char* error_message(Schema_errc code) noexcept
+	{
+		static constexpr const char* messages[] = {
+			"no error", "type is not allowed", "value is not in enum", "required member is missing",
+			"number is below minimum", "number is above maximum", "string is too short",
+			"string is too long", "array has too few items", "array has too many items" };
+		return messages[static_cast<size_t>(code)];
+	}
+
+	struct Schema_error
+	{
+		Schema_errc code = Schema_errc::None;
+		std::string path; //json pointer of the failing value, e.g. /events/3/name
+
+		explicit operator bool() const noexcept //true on failure
+		{
+			return code != Schema_errc::None;
+		}
+
+		const char* message() const noexcept
+		{
+			return error_message(code);
+		}
+	};
+
 	class input_error :public std::runtime_error
 	{
 	public:
 		using std::runtime_error::runtime_error;
+
+		explicit input_error(const Parse_error& e)
+			: std::runtime_error(describe(e)), parse_error(e) {}
+
+		const Parse_error& error() const noexcept //code None unless thrown by a text parse or a depth limit
+		{
+			return parse_error;
+		}
+	private:
+		static std::string describe(const Parse_error& e)
+		{
+			if (e.line == 0)
+				return e.message();
+			return "line " + std::to_string(e.line) + ", column " + std::to_string(e.column)
+				+ ": " + e.message();
+		}
+
+		Parse_error parse_error;
 	};
 
 	enum class Token
@@ -45,7 +193,9 @@ namespace jasoon
 		Float,
 		True,
 		False,
-		Null
+		Null,
+		End,             //no input is left
+		Error            //the lexer failed, see Lexer::error()
 	};
 
 	enum class Json_type
@@ -64,891 +214,5358 @@ namespace jasoon
 		String, File
 	};
 
-	template<
-		template<typename Key, typename Value, typename... Args>
-	typename Object_type = std::unordered_map,
-		template<typename Value, typename... Args>
-	typename Array_type = std::vector,
-		typename String_type = std::string,
-		typename Interger_type = std::int64_t,
-		typename Float_type = double,
-		typename Boolean_type = bool,
-		template<typename T> typename Allocator_type = std::allocator>
-	class Basic_json
-	{
-	public:
-		using value_type = Basic_json;
-
-		using reference = value_type & ;
+	//opt-in instrumentation: define JASOON_ENABLE_STATS before including json.h to fill
+	//Parse_stats/Stringify_stats, otherwise every counter below is compiled out
+#ifdef JASOON_ENABLE_STATS
+#define JASOON_STAT(...) __VA_ARGS__
+	constexpr bool stats_enabled = true;
+#else
+#define JASOON_STAT(...)
+	constexpr bool stats_enabled = false;
+#endif
 
-		using const_reference = const reference;
+	constexpr size_t token_kinds = static_cast<size_t>(Token::Null) + 1; //Token::Error is not counted
 
-		using size_type = size_t;
+	constexpr size_t json_types = static_cast<size_t>(Json_type::Null) + 1;
 
-		using difference_type = ptrdiff_t;
+	//bounds a parse fails on with input_error before doing the work, for untrusted input.
+	//the depth default also keeps the recursive stringify/copy/destroy of the result bounded
+	struct Parse_limits
+	{
+		size_t max_depth = 1024; //nested arrays and objects
+		size_t max_document_size = std::numeric_limits<size_t>::max(); //bytes of input
+		size_t max_string_length = std::numeric_limits<size_t>::max(); //bytes of a single string or member name
+		size_t max_elements = std::numeric_limits<size_t>::max(); //elements of an array, members of an object
+	};
 
-		using object_t = Object_type<String_type,
-			Basic_json,
-			std::hash<String_type>,
-			std::equal_to<String_type>,
-			Allocator_type<std::pair<const String_type, Basic_json>>>;
+	struct Phase_timer //adds the lifetime of the scope to a phase
+	{
+		explicit Phase_timer(std::chrono::nanoseconds& t) noexcept
+			: total(t), start(std::chrono::steady_clock::now()) {}
+		~Phase_timer()
+		{
+			total += std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now() - start);
+		}
+		std::chrono::nanoseconds& total;
+		std::chrono::steady_clock::time_point start;
+	};
 
-		using array_t = Array_type<Basic_json, Allocator_type<Basic_json>>;
+	struct Parse_stats
+	{
+		size_t bytes = 0;
+		std::array<size_t, token_kinds> tokens{}; //indexed by Token
+		size_t max_depth = 0;
+		std::array<size_t, json_types> nodes{}; //indexed by Json_type
+		size_t string_bytes = 0; //string values and member names
+		size_t node_allocations = 0; //containers, strings and members made new instead of reused from a Document
+		std::chrono::nanoseconds read_time{}; //loading InputMode::File
+		std::chrono::nanoseconds parse_time{};
 
-		using string_t = String_type;
+		template<typename F>
+		void visit(F&& f) const //f(name, value) for every counter, for metrics export
+		{
+			static constexpr const char* token_names[token_kinds] = {
+				"tokens.object_begin", "tokens.object_end", "tokens.array_begin", "tokens.array_end",
+				"tokens.name_separator", "tokens.value_separator", "tokens.string", "tokens.interger",
+				"tokens.float", "tokens.true", "tokens.false", "tokens.null" };
+			static constexpr const char* node_names[json_types] = {
+				"nodes.object", "nodes.array", "nodes.string", "nodes.interger",
+				"nodes.float", "nodes.boolean", "nodes.null" };
+			f("bytes", bytes);
+			for (size_t i = 0; i < token_kinds; ++i)
+				f(token_names[i], tokens[i]);
+			f("max_depth", max_depth);
+			for (size_t i = 0; i < json_types; ++i)
+				f(node_names[i], nodes[i]);
+			f("string_bytes", string_bytes);
+			f("node_allocations", node_allocations);
+			f("read_ns", static_cast<size_t>(read_time.count()));
+			f("parse_ns", static_cast<size_t>(parse_time.count()));
+		}
+	};
 
-		using interger_t = Interger_type;
+	struct Stringify_stats
+	{
+		size_t bytes = 0;
+		size_t max_depth = 0;
+		std::array<size_t, json_types> nodes{}; //indexed by Json_type
+		size_t string_bytes = 0; //string values and member names
+		std::chrono::nanoseconds stringify_time{};
 
-		using float_t = Float_type;
+		template<typename F>
+		void visit(F&& f) const
+		{
+			static constexpr const char* node_names[json_types] = {
+				"nodes.object", "nodes.array", "nodes.string", "nodes.interger",
+				"nodes.float", "nodes.boolean", "nodes.null" };
+			f("bytes", bytes);
+			f("max_depth", max_depth);
+			for (size_t i = 0; i < json_types; ++i)
+				f(node_names[i], nodes[i]);
+			f("string_bytes", string_bytes);
+			f("stringify_ns", static_cast<size_t>(stringify_time.count()));
+		}
+	};
 
-		using boolean_t = Boolean_type;
+	//snapshot: a pointer-free image of a document that is used in place, e.g. straight from mmap.
+	//every offset is relative to the start of the image, all records are 8-byte aligned and in
+	//host byte order; object entries are sorted by key so lookups are a binary search.
+	struct Snapshot_node
+	{
+		std::uint32_t type;    //Json_type
+		std::uint32_t size;    //element count of containers, byte length of strings
+		std::uint64_t payload; //offset of children/chars, or the bits of a scalar
+	};
 
-	private:
-		using object_ptr = std::unique_ptr<object_t>; //used in varaint
+	struct Snapshot_entry
+	{
+		std::uint64_t key_offset;
+		std::uint32_t key_size;
+		std::uint32_t reserved;
+		Snapshot_node value;
+	};
 
-		using array_ptr = std::unique_ptr<array_t>; //used in varaint
+	struct Snapshot_header
+	{
+		char magic[4];
+		std::uint16_t byte_order;
+		std::uint16_t version;
+		std::uint64_t size;
+		Snapshot_node root;
+	};
 
-		using string_ptr = std::unique_ptr<string_t>; //used in varaint
+	constexpr std::uint16_t snapshot_byte_order = 0x0102;
 
-		using Json_value = std::variant<
-			object_ptr,
-			array_ptr,
-			string_ptr,
-			interger_t,
-			float_t,
-			boolean_t>;
+	constexpr std::uint16_t snapshot_version = 1;
 
+	class Json_view //read-only access to a snapshot node
+	{
 	public:
+		constexpr Json_view() noexcept : base(nullptr), node(&null_node) {}
+
+		Json_view(const std::uint8_t* b, const Snapshot_node* n) noexcept : base(b), node(n) {}
 
 		bool is_object() const noexcept
 		{
-			return type == Json_type::Object;
+			return get_type() == Json_type::Object;
 		}
 
 		bool is_array() const noexcept
 		{
-			return type == Json_type::Array;
+			return get_type() == Json_type::Array;
 		}
 
 		bool is_string() const noexcept
 		{
-			return type == Json_type::String;
+			return get_type() == Json_type::String;
 		}
 
 		bool is_interger() const noexcept
 		{
-			return type == Json_type::Interger;
+			return get_type() == Json_type::Interger;
 		}
 
 		bool is_float() const noexcept
 		{
-			return type == Json_type::Float;
+			return get_type() == Json_type::Float;
 		}
 
 		bool is_boolean() const noexcept
 		{
-			return type == Json_type::Boolean;
+			return get_type() == Json_type::Boolean;
 		}
 
 		bool is_null() const noexcept
 		{
-			return type == Json_type::Null;
+			return get_type() == Json_type::Null;
 		}
 
 		Json_type get_type() const noexcept
 		{
-			return type;
+			return static_cast<Json_type>(node->type);
+		}
+
+		size_t size() const
+		{
+			if (is_object() || is_array())
+				return node->size;
+			else
+				throw type_error("only object or array has size");
 		}
 
 		template<typename T>
-		operator T() const noexcept //implicit cast operation
+		operator T() const noexcept
 		{
-			if constexpr(std::is_convertible_v<T, object_t>)
+			if constexpr(std::is_same_v<T, std::string_view>
+				|| std::is_constructible_v<T, std::string_view>)
 			{
-				return *std::get<object_ptr>(value);
+				return T(chars(node->payload, node->size));
 			}
-			else if constexpr(std::is_convertible_v<T, array_t>)
+			else if constexpr(std::is_same_v<T, bool>)
 			{
-				return *std::get<array_ptr>(value);
+				return node->payload != 0;
 			}
-			else if constexpr(std::is_convertible_v<T, string_t>)
+			else if constexpr(std::is_integral_v<T>)
 			{
-				return *std::get<string_ptr>(value);
+				return static_cast<T>(static_cast<std::int64_t>(node->payload));
 			}
-			else if constexpr(std::is_same_v<T, interger_t>
-				|| std::is_same_v<T, float_t>
-				|| std::is_same_v<T, boolean_t>)
+			else if constexpr(std::is_floating_point_v<T>)
 			{
-				return std::get<T>(value);
+				double d;
+				std::memcpy(&d, &node->payload, sizeof(d));
+				return static_cast<T>(d);
 			}
-			else if constexpr(std::is_integral_v<T>)
+		}
+
+		template<typename T>
+		Json_view operator[](T index) const noexcept
+		{
+			if constexpr(std::is_integral_v<T>)
 			{
-				return std::get<interger_t>(value);
+				return Json_view(base, children() + index);
 			}
-			else if constexpr(std::is_floating_point_v<T>)
+			else //T can be char* , std::string ...
 			{
-				return std::get<float_t>(value);
+				const auto entry = find(std::string_view(index));
+				return entry ? Json_view(base, &entry->value) : Json_view();
 			}
-			else if constexpr(std::is_convertible_v<T, boolean_t>)
+		}
+
+		template<typename T>
+		Json_view at(T index) const //provide check with type and index
+		{
+			if constexpr(std::is_integral_v<T>)
 			{
-				return std::get<boolean_t>(value);
+				if (!is_array())
+					throw type_error("only array is valid");
+				if (index < 0 || static_cast<size_t>(index) >= node->size)
+					throw std::out_of_range("array index out of range");
+				return Json_view(base, children() + index);
 			}
 			else
 			{
-				return nullptr;
+				if (!is_object())
+					throw type_error("only object is valid");
+				const auto entry = find(std::string_view(index));
+				if (!entry)
+					throw std::out_of_range("key not found");
+				return Json_view(base, &entry->value);
 			}
 		}
 
-	public:
-		void push_back(const_reference element) const
+		bool contains(std::string_view key) const noexcept
 		{
-			if (is_object()
-				&& element.is_array()
-				&& element.size() == 2
-				&& element[0].is_string())
-				std::get<object_ptr>(value)
-				->emplace(
-					*std::get<string_ptr>(element[0].value), element[1]);
-			else if (is_array())
-				std::get<array_ptr>(value)->push_back(element);
-			else
-				throw type_error("only object or array provide push_back");
+			return is_object() && find(key) != nullptr;
 		}
-		void push_back(value_type&& element)
+
+		std::string_view key(size_t i) const noexcept //i-th key of an object in sorted order
 		{
-			if (is_object()
-				&& element.is_array()
-				&& element.size() == 2
-				&& element[0].is_string())
-				std::get<object_ptr>(value)
-				->emplace(
-					std::move(*std::get<string_ptr>(element[0].value)), std::move(element[1]));
-			else if (is_array())
-				std::get<array_ptr>(value)->push_back(element);
-			else
-				throw type_error("only object or array provide push_back");
+			const auto& entry = entries()[i];
+			return chars(entry.key_offset, entry.key_size);
 		}
-		size_type size() const
+
+		Json_view value(size_t i) const noexcept //i-th value of an object in key order
 		{
-			if (is_object())
-				return std::get<object_ptr>(value)->size();
-			if (is_array())
-				return std::get<array_ptr>(value)->size();
-			else
-				throw type_error("only object or array has size");
+			return Json_view(base, &entries()[i].value);
 		}
+
 	private:
+		static constexpr Snapshot_node null_node{ static_cast<std::uint32_t>(Json_type::Null), 0, 0 };
 
-		class Lexer
+		const std::uint8_t* base;
+		const Snapshot_node* node;
+
+		std::string_view chars(std::uint64_t offset, std::uint32_t size) const noexcept
 		{
-		public:
+			return std::string_view(reinterpret_cast<const char*>(base + offset), size);
+		}
 
-			Token getToken()
+		const Snapshot_node* children() const noexcept
+		{
+			return reinterpret_cast<const Snapshot_node*>(base + node->payload);
+		}
+
+		const Snapshot_entry* entries() const noexcept
+		{
+			return reinterpret_cast<const Snapshot_entry*>(base + node->payload);
+		}
+
+		const Snapshot_entry* find(std::string_view name) const noexcept
+		{
+			if (!is_object())
+				return nullptr;
+			const auto first = entries();
+			const auto last = first + node->size;
+			const auto it = std::lower_bound(first, last, name, [this](const auto& entry, std::string_view k)
 			{
-				skipSpace();
-				switch (last_char)
-				{
-				case'{':
+				return chars(entry.key_offset, entry.key_size) < k;
+			});
+			if (it != last && chars(it->key_offset, it->key_size) == name)
+				return it;
+			return nullptr;
+		}
+	};
+
+	class Snapshot //owns a snapshot image, either mapped from a file or held in memory
+	{
+	public:
+		Snapshot() noexcept = default;
+
+		Snapshot(const Snapshot&) = delete;
+
+		Snapshot& operator=(const Snapshot&) = delete;
+
+		Snapshot(Snapshot&& other) noexcept
+		{
+			*this = std::move(other);
+		}
+
+		Snapshot& operator=(Snapshot&& other) noexcept
+		{
+			if (this != &other)
+			{
+				release();
+				buffer = std::move(other.buffer);
+				data = other.data;
+				length = other.length;
+				mapping = other.mapping;
+				other.data = nullptr;
+				other.length = 0;
+				other.mapping = nullptr;
+			}
+			return *this;
+		}
+
+		~Snapshot()
+		{
+			release();
+		}
+
+		static Snapshot open(const std::string& path) //maps the file read-only
+		{
+			Snapshot snapshot;
+#ifdef _WIN32
+			const auto file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+				OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (file == INVALID_HANDLE_VALUE)
+				throw input_error("cannot open snapshot file");
+			LARGE_INTEGER file_size;
+			if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0)
+			{
+				CloseHandle(file);
+				throw input_error("cannot map snapshot file");
+			}
+			const auto mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			CloseHandle(file);
+			if (!mapping)
+				throw input_error("cannot map snapshot file");
+			const auto view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+			if (!view)
+			{
+				CloseHandle(mapping);
+				throw input_error("cannot map snapshot file");
+			}
+			snapshot.mapping = mapping;
+			snapshot.data = static_cast<const std::uint8_t*>(view);
+			snapshot.length = static_cast<size_t>(file_size.QuadPart);
+#else
+			const int fd = ::open(path.c_str(), O_RDONLY);
+			if (fd < 0)
+				throw input_error("cannot open snapshot file");
+			struct stat st;
+			if (fstat(fd, &st) != 0 || st.st_size == 0)
+			{
+				::close(fd);
+				throw input_error("cannot map snapshot file");
+			}
+			void* address = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+			::close(fd);
+			if (address == MAP_FAILED)
+				throw input_error("cannot map snapshot file");
+			snapshot.mapping = address;
+			snapshot.data = static_cast<const std::uint8_t*>(address);
+			snapshot.length = static_cast<size_t>(st.st_size);
+#endif
+			snapshot.validate();
+			return snapshot;
+		}
+
+		static Snapshot from_buffer(std::vector<std::uint8_t> image)
+		{
+			Snapshot snapshot;
+			snapshot.buffer = std::move(image);
+			snapshot.data = snapshot.buffer.data();
+			snapshot.length = snapshot.buffer.size();
+			snapshot.validate();
+			return snapshot;
+		}
+
+		Json_view root() const noexcept
+		{
+			return Json_view(data, &reinterpret_cast<const Snapshot_header*>(data)->root);
+		}
+
+		size_t size() const noexcept
+		{
+			return length;
+		}
+
+	private:
+		std::vector<std::uint8_t> buffer;
+		const std::uint8_t* data = nullptr;
+		size_t length = 0;
+		void* mapping = nullptr;
+
+		//Json_view does not check offsets on access, so every one of them is checked here, once:
+		//a truncated or corrupt image fails to open instead of being read out of bounds
+		void validate() const
+		{
+			const auto header = reinterpret_cast<const Snapshot_header*>(data);
+			if (!data || length < sizeof(Snapshot_header)
+				|| reinterpret_cast<std::uintptr_t>(data) % alignof(Snapshot_header) != 0
+				|| std::memcmp(header->magic, "JSNP", 4) != 0
+				|| header->byte_order != snapshot_byte_order
+				|| header->version != snapshot_version
+				|| header->size != length)
+				throw input_error("invalid snapshot");
+			struct Pending
+			{
+				const Snapshot_node* node;
+				size_t depth;
+			};
+			std::vector<Pending> pending{ { &header->root, 0 } };
+			auto nodes_left = length / sizeof(Snapshot_node); //what the image can hold, so a cycle ends
+			while (!pending.empty())
+			{
+				const auto [node, depth] = pending.back();
+				pending.pop_back();
+				if (nodes_left-- == 0)
+					throw input_error("invalid snapshot");
+				switch (static_cast<Json_type>(node->type))
 				{
-					getChar();
-					return Token::Object_begin;
-				}
-				case'}':
+				case Json_type::String:
+					if (!within(node->payload, node->size))
+						throw input_error("invalid snapshot");
+					break;
+				case Json_type::Array:
 				{
-					getChar();
-					return Token::Object_end;
+					const auto children = records<Snapshot_node>(*node, depth);
+					for (size_t i = 0; i < node->size; ++i)
+						pending.push_back({ children + i, depth + 1 });
+					break;
 				}
-				case'[':
+				case Json_type::Object:
 				{
-					getChar();
-					return Token::Array_begin;
+					const auto entries = records<Snapshot_entry>(*node, depth);
+					for (size_t i = 0; i < node->size; ++i)
+					{
+						const auto& entry = entries[i];
+						if (!within(entry.key_offset, entry.key_size)
+							|| (i > 0 && key(entry) < key(entries[i - 1]))) //lookups are a binary search
+							throw input_error("invalid snapshot");
+						pending.push_back({ &entry.value, depth + 1 });
+					}
+					break;
 				}
-				case']':
-				{
-					getChar();
-					return Token::Array_end;
-				}
-				case':':
-				{
-					getChar();
-					return Token::Name_separator;
-				}
-				case',':
-				{
-					getChar();
-					return Token::Value_separator;
-				}
-				case'"':
-					return scanString();
-				case'-':[[fallthrough]];
-				case'0':
-				case'1':
-				case'2':
-				case'3':
-				case'4':
-				case'5':
-				case'6':
-				case'7':
-				case'8':
-				case'9':
-					return scanNumber();
-				case't': //true
-				case'f': //false
-					return scanBoolean();
-				case'n': //null
-					return scanNull();
+				case Json_type::Interger:
+				case Json_type::Float:
+				case Json_type::Boolean:
+				case Json_type::Null:
+					break;
 				default:
-				{
-					std::cerr << "'line " << line_no << "': unexpected character";
-					throw input_error("invalid input");
-				}
+					throw input_error("invalid snapshot");
 				}
 			}
+		}
+
+		bool within(std::uint64_t offset, std::uint64_t bytes) const noexcept
+		{
+			return offset <= length && bytes <= length - offset;
+		}
+
+		template<typename T>
+		const T* records(const Snapshot_node& node, size_t depth) const //children of a container
+		{
+			if (depth >= Parse_limits().max_depth || node.payload % alignof(T) != 0
+				|| !within(node.payload, std::uint64_t(node.size) * sizeof(T)))
+				throw input_error("invalid snapshot");
+			return reinterpret_cast<const T*>(data + node.payload);
+		}
+
+		std::string_view key(const Snapshot_entry& entry) const noexcept
+		{
+			return std::string_view(reinterpret_cast<const char*>(data + entry.key_offset), entry.key_size);
+		}
+
+		void release() noexcept
+		{
+			if (!mapping)
+				return;
+#ifdef _WIN32
+			UnmapViewOfFile(data);
+			CloseHandle(mapping);
+#else
+			munmap(mapping, length);
+#endif
+			mapping = nullptr;
+		}
+	};
+
+	//parses at compile time into a snapshot image, which is how "..."_json literals are checked by
+	//the compiler and laid out in read-only data. the grammar is the parser's: an object or array
+	//root, a ',' allowed before a closer, an escaped char kept as is, the first of duplicate names
+	//wins. a malformed literal stops the compile in fail(); at run time it throws input_error
+	class Static_parser
+	{
+	public:
+		static constexpr std::vector<std::uint8_t> build(std::string_view s)
+		{
+			Static_parser parser(s);
+			std::vector<std::uint8_t> out(sizeof(Snapshot_header));
+			parser.skipSpace();
+			if (parser.peek() != '{' && parser.peek() != '[')
+				parser.fail(Parse_errc::Root_expected);
+			const auto root = parser.value(out, 0);
+			parser.skipSpace();
+			if (parser.pos != s.size())
+				parser.fail(Parse_errc::Trailing_characters);
+			put(out, 0, Snapshot_header{ { 'J', 'S', 'N', 'P' }, snapshot_byte_order, snapshot_version,
+				out.size(), root });
+			return out;
+		}
+
+		template<size_t N>
+		static constexpr std::array<std::uint8_t, N> image(std::string_view s) //N is build(s).size()
+		{
+			std::array<std::uint8_t, N> bytes{};
+			const auto out = build(s);
+			std::copy(out.begin(), out.end(), bytes.begin());
+			return bytes;
+		}
+	private:
+		std::string_view text;
+		size_t pos = 0;
+
+		constexpr explicit Static_parser(std::string_view s) noexcept : text(s) {}
 
-			void getChar() //read next char from stream
+		[[noreturn]] void fail(Parse_errc code) const
+		{
+			throw input_error(Parse_error::at(text, code, pos));
+		}
+
+		constexpr int peek() const noexcept
+		{
+			return pos < text.size() ? static_cast<unsigned char>(text[pos]) : EOF;
+		}
+
+		constexpr void skipSpace() noexcept
+		{
+			while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\n'
+				|| text[pos] == '\r' || text[pos] == '\f' || text[pos] == '\v'))
+				++pos;
+		}
+
+		static constexpr std::uint64_t alloc(std::vector<std::uint8_t>& out, size_t bytes)
+		{
+			const auto offset = (out.size() + 7) & ~size_t(7); //keep every record 8-byte aligned
+			out.resize(offset + bytes);
+			return offset;
+		}
+
+		template<typename T>
+		static constexpr void put(std::vector<std::uint8_t>& out, size_t offset, const T& record)
+		{
+			const auto bytes = std::bit_cast<std::array<std::uint8_t, sizeof(T)>>(record);
+			std::copy(bytes.begin(), bytes.end(), out.begin() + offset);
+		}
+
+		static constexpr std::uint64_t putString(std::vector<std::uint8_t>& out, std::string_view s)
+		{
+			const auto offset = alloc(out, s.size() + 1); //nul terminated for c apis
+			std::copy(s.begin(), s.end(), out.begin() + offset);
+			return offset;
+		}
+
+		constexpr std::uint32_t size32(size_t n) const
+		{
+			if (n > std::numeric_limits<std::uint32_t>::max())
+				fail(Parse_errc::Too_many_elements);
+			return static_cast<std::uint32_t>(n);
+		}
+
+		constexpr Snapshot_node value(std::vector<std::uint8_t>& out, size_t depth)
+		{
+			skipSpace();
+			Snapshot_node node{ static_cast<std::uint32_t>(Json_type::Null), 0, 0 };
+			switch (peek())
+			{
+			case'{':
+				return object(out, depth + 1);
+			case'[':
+				return array(out, depth + 1);
+			case'"':
 			{
-				last_char = stream->get();
-				if (last_char == '\n') //update line number
-					++line_no;
+				const auto s = string();
+				node.type = static_cast<std::uint32_t>(Json_type::String);
+				node.size = size32(s.size());
+				node.payload = putString(out, s);
+				return node;
 			}
+			case't':
+				literal("true");
+				node.type = static_cast<std::uint32_t>(Json_type::Boolean);
+				node.payload = 1;
+				return node;
+			case'f':
+				literal("false");
+				node.type = static_cast<std::uint32_t>(Json_type::Boolean);
+				return node;
+			case'n':
+				literal("null");
+				return node;
+			case'}':
+			case']':
+			case':':
+			case',':
+				fail(Parse_errc::Value_expected);
+			default:
+				if (peek() != '-' && (peek() < '0' || peek() > '9'))
+					fail(Parse_errc::Unexpected_character);
+				return number();
+			}
+		}
 
-			int getLineNo() const noexcept
+		constexpr Snapshot_node object(std::vector<std::uint8_t>& out, size_t depth)
+		{
+			if (depth > Parse_limits().max_depth)
+				fail(Parse_errc::Nesting_too_deep);
+			++pos;
+			struct Member
+			{
+				std::string name;
+				size_t index; //in the text, so the first of equal names sorts first
+				Snapshot_node value;
+			};
+			std::vector<Member> members;
+			for (skipSpace(); peek() != '}';)
+			{
+				if (peek() != '"')
+					fail(Parse_errc::Name_expected);
+				auto name = string();
+				skipSpace();
+				if (peek() != ':')
+					fail(Parse_errc::Name_separator_expected);
+				++pos;
+				const auto element = value(out, depth);
+				members.push_back({ std::move(name), members.size(), element });
+				if (!separator('}'))
+					fail(Parse_errc::Object_end_expected);
+			}
+			++pos;
+			std::sort(members.begin(), members.end(), [](const Member& a, const Member& b)
 			{
-				return line_no;
+				return a.name != b.name ? a.name < b.name : a.index < b.index;
+			});
+			members.erase(std::unique(members.begin(), members.end(), [](const Member& a, const Member& b)
+			{
+				return a.name == b.name;
+			}), members.end());
+			Snapshot_node node{ static_cast<std::uint32_t>(Json_type::Object), size32(members.size()), 0 };
+			node.payload = alloc(out, members.size() * sizeof(Snapshot_entry));
+			for (size_t i = 0; i < members.size(); ++i)
+			{
+				const auto key_offset = putString(out, members[i].name);
+				put(out, node.payload + i * sizeof(Snapshot_entry),
+					Snapshot_entry{ key_offset, size32(members[i].name.size()), 0, members[i].value });
 			}
+			return node;
+		}
 
-			void skipSpace()
+		constexpr Snapshot_node array(std::vector<std::uint8_t>& out, size_t depth)
+		{
+			if (depth > Parse_limits().max_depth)
+				fail(Parse_errc::Nesting_too_deep);
+			++pos;
+			std::vector<Snapshot_node> elements;
+			for (skipSpace(); peek() != ']';)
 			{
-				while (std::isspace(last_char))
-				{
-					getChar();
-				}
+				elements.push_back(value(out, depth));
+				if (!separator(']'))
+					fail(Parse_errc::Array_end_expected);
 			}
+			++pos;
+			Snapshot_node node{ static_cast<std::uint32_t>(Json_type::Array), size32(elements.size()), 0 };
+			node.payload = alloc(out, elements.size() * sizeof(Snapshot_node));
+			for (size_t i = 0; i < elements.size(); ++i)
+				put(out, node.payload + i * sizeof(Snapshot_node), elements[i]);
+			return node;
+		}
 
-			template<typename T>
-			decltype(auto) getValue() const noexcept
+		constexpr bool separator(char end) noexcept //after a value: ',' or end, left in front of end
+		{
+			skipSpace();
+			if (peek() == ',')
 			{
-				return std::get<T>(value);
+				++pos;
+				skipSpace();
+				return true;
 			}
+			return peek() == end;
+		}
 
-			void setStream(const string_t& s, InputMode mode)
+		constexpr std::string string()
+		{
+			std::string s;
+			for (++pos; peek() != '"'; ++pos)
 			{
-				last_char = ' '; //reset the token stream
-				line_no = 1;
-				if (mode == InputMode::String)
-				{
-					stream = std::make_unique<std::istringstream>(s);
-				}
-				else //mode == InputMode::File
-				{
-					stream = std::make_unique<std::ifstream>(s);
-				}
+				if (peek() == EOF)
+					fail(Parse_errc::Unterminated_string);
+				if (peek() == '\\' && ++pos == text.size()) //keep the escaped char as is
+					fail(Parse_errc::Unterminated_string);
+				s += text[pos];
 			}
+			++pos;
+			return s;
+		}
 
-		private:
-			std::unique_ptr<std::istream> stream;
-			int last_char = ' ';
-			std::variant<string_t, interger_t, float_t> value;
-			int line_no;
-			std::string buffer;
+		constexpr void literal(std::string_view word)
+		{
+			for (const auto c : word)
+			{
+				if (peek() != c)
+					fail(Parse_errc::Invalid_literal);
+				++pos;
+			}
+		}
 
-			Token scanString()
+		constexpr Snapshot_node number()
+		{
+			const auto start = pos;
+			bool is_float = false;
+			for (; pos < text.size(); ++pos) //the run the lexer takes for a number
 			{
-				string_t s;
-				bool escape = false;
-				getChar();
-				while (escape || last_char != '"')
-				{
-					if (!escape && last_char == '\\')
-					{
-						escape = true;
-					}
-					else
-					{
-						escape = false;
-						s += last_char;
-					}
-					getChar();
-				}
-				getChar();
-				//std::cout << buffer.to_string();
-				value = std::move(s);
-				return Token::String;
+				const auto c = text[pos];
+				if (c == '.' || c == 'e' || c == 'E')
+					is_float = true;
+				else if ((c < '0' || c > '9') && c != '+' && c != '-')
+					break;
+			}
+			const auto run = text.substr(start, pos - start);
+			Snapshot_node node{ static_cast<std::uint32_t>(is_float ? Json_type::Float : Json_type::Interger), 0, 0 };
+			const auto bits = is_float ? floatBits(run) : integerBits(run);
+			if (!bits)
+			{
+				pos = start;
+				fail(Parse_errc::Invalid_number);
 			}
+			node.payload = *bits;
+			return node;
+		}
 
-			Token scanNumber()
+		static constexpr std::optional<std::uint64_t> integerBits(std::string_view run)
+		{
+			const auto negative = !run.empty() && run[0] == '-';
+			const auto digits = run.substr(negative ? 1 : 0);
+			if (digits.empty())
+				return std::nullopt;
+			const std::uint64_t limit = negative ? std::uint64_t(1) << 63 : (std::uint64_t(1) << 63) - 1;
+			std::uint64_t n = 0;
+			for (const auto c : digits)
 			{
-				buffer.clear();
-				bool is_float = false;
-				while (std::isdigit(last_char)
-					|| last_char == '.'
-					|| last_char == '+'
-					|| last_char == '-'
-					|| last_char == 'e'
-					|| last_char == 'E')
-				{
-					if (last_char == '.')
-						is_float = true;
-					buffer += last_char;
-					getChar();
-				}
-				if (is_float)
+				if (c < '0' || c > '9' || n > (limit - (c - '0')) / 10)
+					return std::nullopt;
+				n = n * 10 + (c - '0');
+			}
+			return negative ? ~n + 1 : n; //two's complement of -n
+		}
+
+		//correctly rounded like std::from_chars, and out of range where it is, including a nonzero
+		//value that rounds to zero: exact for up to 15 digits and 10^22, otherwise a big-integer
+		//division finds the nearest double
+		static constexpr std::optional<std::uint64_t> floatBits(std::string_view run)
+		{
+			size_t i = 0;
+			const auto negative = run[0] == '-';
+			if (negative)
+				++i;
+			std::string digits; //significant, no leading zeros
+			long long exponent = 0;
+			bool seen_digit = false;
+			bool seen_point = false;
+			for (; i < run.size(); ++i)
+			{
+				const auto c = run[i];
+				if (c == '.' && !seen_point)
+					seen_point = true;
+				else if (c >= '0' && c <= '9')
 				{
-					value = static_cast<float_t>(std::stod(buffer));
-					return Token::Float;
+					seen_digit = true;
+					if (c != '0' || !digits.empty())
+						digits += c;
+					if (seen_point)
+						--exponent;
 				}
 				else
+					break;
+			}
+			if (!seen_digit)
+				return std::nullopt;
+			if (i < run.size()) //exponent part
+			{
+				if (run[i] != 'e' && run[i] != 'E')
+					return std::nullopt;
+				++i;
+				const auto exponent_negative = i < run.size() && run[i] == '-';
+				if (i < run.size() && (run[i] == '-' || run[i] == '+'))
+					++i;
+				if (i == run.size())
+					return std::nullopt;
+				long long e = 0;
+				for (; i < run.size(); ++i)
 				{
-					value = static_cast<interger_t>(std::stoll(buffer));
-					return Token::Interger;
+					if (run[i] < '0' || run[i] > '9')
+						return std::nullopt;
+					e = std::min(e * 10 + (run[i] - '0'), 1000000LL);
 				}
+				exponent += exponent_negative ? -e : e;
 			}
-
-			Token scanBoolean()
+			const auto sign = negative ? std::uint64_t(1) << 63 : 0;
+			while (!digits.empty() && digits.back() == '0')
 			{
-				using namespace std::string_view_literals;
-				static constexpr auto true_literal = "true"sv;
-				static constexpr auto false_literal = "false"sv;
-				if (last_char == 't')
+				digits.pop_back();
+				++exponent;
+			}
+			const auto magnitude = static_cast<long long>(digits.size()) + exponent; //value < 10^magnitude
+			if (digits.empty())
+				return sign;
+			if (magnitude < -330)
+				return std::nullopt; //out of range, as std::from_chars has it
+			if (magnitude > 310)
+				return std::nullopt; //out of range
+			if (digits.size() <= 15 && exponent >= -22 && exponent <= 22)
+			{
+				constexpr double powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+					1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+				double m = 0;
+				for (const auto c : digits)
+					m = m * 10 + (c - '0'); //exact below 2^53
+				const auto d = exponent < 0 ? m / powers[-exponent] : m * powers[exponent];
+				return std::bit_cast<std::uint64_t>(d) | sign;
+			}
+			//value = u / v, scaled by 2^shift so that the quotient has 54 or 55 bits
+			std::vector<std::uint32_t> u{ 0 };
+			std::vector<std::uint32_t> v{ 1 };
+			for (const auto c : digits)
+				mulAdd(u, 10, static_cast<std::uint32_t>(c - '0'));
+			for (long long e = 0; e < (exponent < 0 ? -exponent : exponent); ++e)
+				mulAdd(exponent < 0 ? v : u, 10, 0);
+			auto shift = static_cast<long long>(bitLength(u)) - static_cast<long long>(bitLength(v)) - 54;
+			shiftLeft(shift > 0 ? v : u, static_cast<size_t>(shift > 0 ? shift : -shift));
+			std::uint64_t q = 0;
+			for (int bit = 55; bit >= 0; --bit) //long division, one quotient bit at a time
+			{
+				auto w = v;
+				shiftLeft(w, static_cast<size_t>(bit));
+				if (compare(u, w) >= 0)
 				{
-					for (const auto& c : true_literal)
-					{
-						if (last_char == c)
-							getChar();
-						else
-						{
-							std::cerr << "invalid true literal";
-							throw input_error("invalid input");
-						}
-					}
-					return Token::True;
+					subtract(u, w);
+					q |= std::uint64_t(1) << bit;
 				}
-				else //last_char == 'f'
+			}
+			const auto rest = bitLength(u) != 0;
+			//round q * 2^shift to 53 bits, or fewer for a subnormal
+			const auto drop = std::max<long long>(static_cast<long long>(std::bit_width(q)) - 53, -1074 - shift);
+			if (drop > 56)
+				return std::nullopt; //below half the smallest subnormal
+			const auto half = (q >> (drop - 1)) & 1;
+			const auto sticky = rest || (q & ((std::uint64_t(1) << (drop - 1)) - 1)) != 0;
+			auto m = q >> drop;
+			shift += drop;
+			if (half && (sticky || (m & 1)))
+			{
+				if (++m == std::uint64_t(1) << 53)
 				{
-					for (const auto& c : false_literal)
-					{
-						if (last_char == c)
-							getChar();
-						else
-						{
-							std::cerr << "invalid false literal";
-							throw input_error("invalid input");
-						}
-					}
-					return Token::False;
+					m >>= 1;
+					++shift;
 				}
 			}
+			if (m == 0)
+				return std::nullopt; //rounds to zero
+			if (m < std::uint64_t(1) << 52) //subnormal, shift is -1074
+				return m | sign;
+			const auto biased = shift + 1075;
+			if (biased >= 2047)
+				return std::nullopt; //out of range
+			return (static_cast<std::uint64_t>(biased) << 52) | (m & ((std::uint64_t(1) << 52) - 1)) | sign;
+		}
 
-			Token scanNull()
+		//little-endian 32-bit limbs, enough for the few numbers that miss the exact path
+		static constexpr void mulAdd(std::vector<std::uint32_t>& a, std::uint32_t factor, std::uint32_t carry)
+		{
+			std::uint64_t c = carry;
+			for (auto& limb : a)
 			{
-				using namespace std::string_view_literals;
-				static constexpr auto null_literal = "null"sv;
-				for (const auto& c : null_literal)
-				{
-					if (last_char == c)
-						getChar();
-					else
-					{
-						std::cerr << "invalid null literal";
-						throw input_error("invalid input");
-					}
-				}
-				return Token::Null;
+				c += static_cast<std::uint64_t>(limb) * factor;
+				limb = static_cast<std::uint32_t>(c);
+				c >>= 32;
 			}
-		};
+			if (c)
+				a.push_back(static_cast<std::uint32_t>(c));
+		}
 
-		class Parser
+		static constexpr size_t bitLength(const std::vector<std::uint32_t>& a)
 		{
-		public:
-			Basic_json parse(string_t s, InputMode mode)
+			for (auto i = a.size(); i-- > 0;)
+				if (a[i])
+					return i * 32 + std::bit_width(a[i]);
+			return 0;
+		}
+
+		static constexpr void shiftLeft(std::vector<std::uint32_t>& a, size_t bits)
+		{
+			a.insert(a.begin(), bits / 32, 0);
+			if (bits % 32 == 0)
+				return;
+			std::uint32_t carry = 0;
+			for (auto& limb : a)
 			{
-				lexer.setStream(s, mode);
-				const auto token = lexer.getToken();
-				if (token == Token::Array_begin)
-					return parseArray();
-				else if (token == Token::Object_begin)
-					return parseObject();
-				else
-				{
-					std::cerr << "must be started with array or object";
-					throw input_error("invalid input");
-				}
+				const auto next = limb >> (32 - bits % 32);
+				limb = (limb << (bits % 32)) | carry;
+				carry = next;
 			}
-		private:
-			Basic_json parseObject()
+			if (carry)
+				a.push_back(carry);
+		}
+
+		static constexpr int compare(const std::vector<std::uint32_t>& a, const std::vector<std::uint32_t>& b)
+		{
+			const auto n = std::max(a.size(), b.size());
+			for (auto i = n; i-- > 0;)
 			{
-				Basic_json object(Json_type::Object); //empty json object
-				auto token = lexer.getToken();
-				string_t name;
-				bool is_name = true;
-				while (token != Token::Object_end)
-				{
-					switch (token)
-					{
-					case Token::Object_begin:
-						object.push_back({ name,parseObject() });
-						break;
-					case Token::Array_begin:
-						object.push_back({ name,parseArray() });
-						break;
-					case Token::Name_separator:
-						is_name = false;
-						break;
-					case Token::Value_separator:
-						is_name = true;
-						break;
-					case Token::String:
-					{
-						//std::cout << lexer.template getValue<string_t>() << ' ';
-						if (is_name)
-							name = lexer.template getValue<string_t>();
-						else
-							object.push_back({ name,lexer.template getValue<string_t>() });
-						break;
-					}
-					case Token::Interger:
-						object.push_back({ name,lexer.template getValue<interger_t>() });
-						break;
-					case Token::Float:
-						object.push_back({ name,lexer.template getValue<float_t>() });
-						break;
-					case Token::True:
-						object.push_back({ name,true });
-						break;
-					case Token::False:
-						object.push_back({ name,false });
-						break;
-					case Token::Null:
-						object.push_back({ name,nullptr });
-						break;
-					case Token::Array_end:
-					default:
-					{
-						std::cerr << "'line " << lexer.getLineNo() << "': '}' is expected";
-						throw input_error("invalid input");
-					}
-					}
-					token = lexer.getToken();
-				}
-				return object;
+				const auto x = i < a.size() ? a[i] : 0;
+				const auto y = i < b.size() ? b[i] : 0;
+				if (x != y)
+					return x < y ? -1 : 1;
+			}
+			return 0;
+		}
+
+		static constexpr void subtract(std::vector<std::uint32_t>& a, const std::vector<std::uint32_t>& b) //a >= b
+		{
+			std::int64_t borrow = 0;
+			for (size_t i = 0; i < a.size(); ++i)
+			{
+				auto d = static_cast<std::int64_t>(a[i]) - (i < b.size() ? b[i] : 0) - borrow;
+				borrow = d < 0;
+				if (d < 0)
+					d += std::int64_t(1) << 32;
+				a[i] = static_cast<std::uint32_t>(d);
+			}
+		}
+	};
+
+	template<size_t N>
+	struct Fixed_string //a string literal as a template argument
+	{
+		constexpr Fixed_string(const char (&s)[N]) noexcept
+		{
+			std::copy_n(s, N, chars);
+		}
+
+		constexpr std::string_view view() const noexcept
+		{
+			return std::string_view(chars, N - 1);
+		}
+
+		char chars[N];
+	};
+
+	template<Fixed_string S>
+	struct Static_json //the snapshot image of one literal, laid out by the compiler
+	{
+		static constexpr size_t size = Static_parser::build(S.view()).size();
+
+		alignas(Snapshot_header) static constexpr std::array<std::uint8_t, size> image
+			= Static_parser::image<size>(S.view());
+
+		static Json_view root() noexcept
+		{
+			return Json_view(image.data(), &reinterpret_cast<const Snapshot_header*>(image.data())->root);
+		}
+	};
+
+	class Thread_pool //work-stealing pool, the calling thread joins in as worker 0
+	{
+	public:
+		explicit Thread_pool(unsigned threads = std::thread::hardware_concurrency())
+			: queues(threads == 0 ? 1 : threads)
+		{
+			for (size_t i = 1; i < queues.size(); ++i)
+				workers.emplace_back([this, i] { work(i); });
+		}
+
+		Thread_pool(const Thread_pool&) = delete;
+
+		Thread_pool& operator=(const Thread_pool&) = delete;
+
+		~Thread_pool()
+		{
+			{
+				std::lock_guard<std::mutex> lock(state_mutex);
+				stopping = true;
+			}
+			wake.notify_all();
+			for (auto& worker : workers)
+				worker.join();
+		}
+
+		size_t size() const noexcept
+		{
+			return queues.size();
+		}
+
+		template<typename F>
+		void parallel_for(size_t count, F&& f) //calls f(i) for every i in [0, count), then returns
+		{
+			if (count == 0)
+				return;
+			std::lock_guard<std::mutex> run(run_mutex); //one loop at a time
+			job = [&f](size_t i) { f(i); };
+			failed = false;
+			error = nullptr;
+			remaining = count;
+			const auto n = queues.size();
+			for (size_t w = 0; w < n; ++w) //contiguous blocks keep neighbouring tasks on one thread
+			{
+				std::lock_guard<std::mutex> lock(queues[w].mutex);
+				for (auto i = count * w / n; i < count * (w + 1) / n; ++i)
+					queues[w].tasks.push_back(i);
+			}
+			{
+				std::lock_guard<std::mutex> lock(state_mutex);
+				++generation;
+			}
+			wake.notify_all();
+			runTasks(0);
+			{
+				std::unique_lock<std::mutex> lock(state_mutex);
+				done.wait(lock, [this] { return remaining == 0; });
+			}
+			job = nullptr;
+			if (error)
+				std::rethrow_exception(error);
+		}
+
+		static Thread_pool& shared() //sized to the machine, created on first use
+		{
+			static Thread_pool pool;
+			return pool;
+		}
+
+	private:
+		struct Queue
+		{
+			std::mutex mutex;
+			std::deque<size_t> tasks;
+		};
+
+		std::vector<Queue> queues;
+		std::vector<std::thread> workers;
+		std::mutex run_mutex;
+		std::mutex state_mutex;
+		std::condition_variable wake;
+		std::condition_variable done;
+		std::function<void(size_t)> job;
+		std::atomic<size_t> remaining{ 0 };
+		std::atomic<bool> failed{ false };
+		std::exception_ptr error;
+		size_t generation = 0;
+		bool stopping = false;
+
+		bool pop(size_t self, size_t& index) //own work from the front
+		{
+			std::lock_guard<std::mutex> lock(queues[self].mutex);
+			if (queues[self].tasks.empty())
+				return false;
+			index = queues[self].tasks.front();
+			queues[self].tasks.pop_front();
+			return true;
+		}
+
+		bool steal(size_t self, size_t& index) //other workers' work from the back
+		{
+			for (size_t i = 1; i < queues.size(); ++i)
+			{
+				auto& victim = queues[(self + i) % queues.size()];
+				std::lock_guard<std::mutex> lock(victim.mutex);
+				if (!victim.tasks.empty())
+				{
+					index = victim.tasks.back();
+					victim.tasks.pop_back();
+					return true;
+				}
+			}
+			return false;
+		}
+
+		void runTasks(size_t self)
+		{
+			size_t index;
+			while (pop(self, index) || steal(self, index))
+			{
+				if (!failed)
+				{
+					try
+					{
+						job(index);
+					}
+					catch (...)
+					{
+						std::lock_guard<std::mutex> lock(state_mutex);
+						if (!error)
+							error = std::current_exception();
+						failed = true;
+					}
+				}
+				if (remaining.fetch_sub(1) == 1)
+				{
+					std::lock_guard<std::mutex> lock(state_mutex);
+					done.notify_all();
+				}
+			}
+		}
+
+		void work(size_t self)
+		{
+			size_t seen = 0;
+			for (;;)
+			{
+				{
+					std::unique_lock<std::mutex> lock(state_mutex);
+					wake.wait(lock, [&] { return stopping || generation != seen; });
+					if (stopping)
+						return;
+					seen = generation;
+				}
+				runTasks(self);
+			}
+		}
+	};
+
+	//an object member name: immutable chars shared by every copy, with the hash computed once.
+	//keys handed out by the same Key_table are one allocation and compare equal by pointer
+	class Key
+	{
+	public:
+		Key() noexcept = default;
+
+		explicit Key(std::string_view s) : Key(s, hashOf(s)) {}
+
+		explicit Key(const std::string& s) : Key(std::string_view(s)) {}
+
+		explicit Key(const char* s) : Key(std::string_view(s)) {}
+
+		Key(const Key& other) noexcept : entry(other.entry)
+		{
+			if (entry)
+				entry->refs.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		Key(Key&& other) noexcept : entry(std::exchange(other.entry, nullptr)) {}
+
+		Key& operator=(const Key& other) noexcept
+		{
+			Key copy(other);
+			std::swap(entry, copy.entry);
+			return *this;
+		}
+
+		Key& operator=(Key&& other) noexcept
+		{
+			std::swap(entry, other.entry);
+			return *this;
+		}
+
+		~Key()
+		{
+			if (entry && entry->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			{
+				entry->~Entry();
+				::operator delete(entry);
+			}
+		}
+
+		const char* data() const noexcept
+		{
+			return entry ? reinterpret_cast<const char*>(entry + 1) : "";
+		}
+
+		size_t size() const noexcept
+		{
+			return entry ? entry->size : 0;
+		}
+
+		bool empty() const noexcept
+		{
+			return size() == 0;
+		}
+
+		const char* begin() const noexcept
+		{
+			return data();
+		}
+
+		const char* end() const noexcept
+		{
+			return data() + size();
+		}
+
+		size_t hash() const noexcept
+		{
+			return entry ? entry->hash : hashOf(std::string_view());
+		}
+
+		operator std::string_view() const noexcept
+		{
+			return std::string_view(data(), size());
+		}
+
+		std::string str() const
+		{
+			return std::string(data(), size());
+		}
+
+		static size_t hashOf(std::string_view s) noexcept //the hash of std::string and string_view
+		{
+			return std::hash<std::string_view>()(s);
+		}
+
+		friend bool operator==(const Key& a, const Key& b) noexcept
+		{
+			return a.entry == b.entry
+				|| (a.hash() == b.hash() && std::string_view(a) == std::string_view(b));
+		}
+
+		friend bool operator==(const Key& a, std::string_view b) noexcept
+		{
+			return std::string_view(a) == b;
+		}
+	private:
+		friend class Key_table;
+
+		struct Entry //followed by the chars
+		{
+			std::atomic<size_t> refs;
+			size_t hash;
+			size_t size;
+		};
+
+		Key(std::string_view s, size_t hash)
+		{
+			auto memory = ::operator new(sizeof(Entry) + s.size());
+			entry = new (memory) Entry{ {1}, hash, s.size() };
+			std::memcpy(reinterpret_cast<char*>(entry + 1), s.data(), s.size());
+		}
+
+		Entry* entry = nullptr;
+	};
+
+	//transparent, so objects are searched by string_view without making a Key
+	struct Key_hash
+	{
+		using is_transparent = void;
+
+		size_t operator()(const Key& key) const noexcept
+		{
+			return key.hash();
+		}
+
+		size_t operator()(std::string_view s) const noexcept
+		{
+			return Key::hashOf(s);
+		}
+	};
+
+	struct Key_equal
+	{
+		using is_transparent = void;
+
+		bool operator()(const Key& a, const Key& b) const noexcept
+		{
+			return a == b;
+		}
+
+		bool operator()(const Key& a, std::string_view b) const noexcept
+		{
+			return a == b;
+		}
+
+		bool operator()(std::string_view a, const Key& b) const noexcept
+		{
+			return b == a;
+		}
+	};
+
+	//interns member names: every distinct name is stored once and its keys share it. a table
+	//stops adding names at its capacity (0 turns interning off) and keeps only short names, so
+	//hostile input cannot grow it without bound. not thread safe, but the keys it hands out
+	//are and outlive it
+	class Key_table
+	{
+	public:
+		static constexpr size_t max_name_length = 64; //longer names get a key of their own
+
+		explicit Key_table(size_t capacity = 4096) : max_keys(capacity) {}
+
+		Key intern(std::string_view s)
+		{
+			if (s.size() > max_name_length)
+				return Key(s, Key::hashOf(s));
+			const auto it = keys.find(s);
+			if (it != keys.end())
+				return *it;
+			Key key(s, Key::hashOf(s));
+			if (keys.size() < max_keys)
+				keys.insert(key);
+			return key;
+		}
+
+		size_t size() const noexcept
+		{
+			return keys.size();
+		}
+
+		size_t capacity() const noexcept
+		{
+			return max_keys;
+		}
+
+		void set_capacity(size_t capacity) //drops every name once the table is over it
+		{
+			max_keys = capacity;
+			if (keys.size() > max_keys)
+				clear();
+		}
+
+		void clear() noexcept //keys already handed out stay valid
+		{
+			keys.clear();
+		}
+	private:
+		std::unordered_set<Key, Key_hash, Key_equal> keys;
+		size_t max_keys;
+	};
+
+	template<
+		template<typename Key, typename Value, typename... Args>
+	typename Object_type = std::unordered_map,
+		template<typename Value, typename... Args>
+	typename Array_type = std::vector,
+		typename String_type = std::string,
+		typename Interger_type = std::int64_t,
+		typename Float_type = double,
+		typename Boolean_type = bool,
+		template<typename T> typename Allocator_type = std::allocator>
+	class Basic_json
+	{
+	public:
+		using value_type = Basic_json;
+
+		using reference = value_type & ;
+
+		using const_reference = const value_type&;
+
+		using size_type = size_t;
+
+		using difference_type = ptrdiff_t;
+
+		//member names are Keys whatever String_type and Allocator_type are: their chars live in a
+		//block from ::operator new, shared through Key_table. Allocator_type only covers the map nodes
+		using key_t = Key;
+
+		using object_t = Object_type<key_t,
+			Basic_json,
+			Key_hash,
+			Key_equal,
+			Allocator_type<std::pair<const key_t, Basic_json>>>;
+
+		using array_t = Array_type<Basic_json, Allocator_type<Basic_json>>;
+
+		using string_t = String_type;
+
+		using interger_t = Interger_type;
+
+		using float_t = Float_type;
+
+		using boolean_t = Boolean_type;
+
+	private:
+		using object_ptr = std::unique_ptr<object_t>; //used in varaint
+
+		using array_ptr = std::unique_ptr<array_t>; //used in varaint
+
+		using string_ptr = std::unique_ptr<string_t>; //used in varaint
+
+		//an array of only interger_t or only float_t may be stored as a contiguous run of numbers
+		template<typename T>
+		using packed_t = Array_type<T, Allocator_type<T>>;
+
+		//the numbers of a packed array. const operator[] and at() return references, so the first
+		//of them builds the matching elements once and keeps them beside the numbers; any write
+		//to the numbers drops them again
+		template<typename T>
+		struct Packed :packed_t<T>
+		{
+			Packed() = default;
+
+			Packed(const Packed& other) : packed_t<T>(other) {}
+
+			Packed& operator=(const Packed&) = delete;
+
+			~Packed()
+			{
+				delete elements.load(std::memory_order_relaxed);
+			}
+
+			const array_t& view() const //safe to call from concurrent readers
+			{
+				if (const auto built = elements.load(std::memory_order_acquire))
+					return *built;
+				auto built = std::make_unique<array_t>();
+				built->reserve(this->size());
+				for (const auto number : *this)
+					built->push_back(Basic_json(number));
+				array_t* expected = nullptr;
+				if (elements.compare_exchange_strong(expected, built.get(), std::memory_order_acq_rel))
+					return *built.release();
+				return *expected; //another reader got there first
+			}
+
+			void changed() noexcept
+			{
+				delete elements.exchange(nullptr, std::memory_order_relaxed);
+			}
+
+			mutable std::atomic<array_t*> elements{ nullptr };
+		};
+
+		template<typename T>
+		using packed_ptr = std::unique_ptr<Packed<T>>; //used in varaint
+
+		using Json_value = std::variant<
+			object_ptr,
+			array_ptr,
+			string_ptr,
+			interger_t,
+			float_t,
+			boolean_t,
+			packed_ptr<interger_t>,
+			packed_ptr<float_t>>;
+
+	public:
+
+		bool is_object() const noexcept
+		{
+			return type == Json_type::Object;
+		}
+
+		bool is_array() const noexcept
+		{
+			return type == Json_type::Array;
+		}
+
+		bool is_string() const noexcept
+		{
+			return type == Json_type::String;
+		}
+
+		bool is_interger() const noexcept
+		{
+			return type == Json_type::Interger;
+		}
+
+		bool is_float() const noexcept
+		{
+			return type == Json_type::Float;
+		}
+
+		bool is_boolean() const noexcept
+		{
+			return type == Json_type::Boolean;
+		}
+
+		bool is_null() const noexcept
+		{
+			return type == Json_type::Null;
+		}
+
+		Json_type get_type() const noexcept
+		{
+			return type;
+		}
+
+		bool is_packed() const noexcept //an array held as packed numbers, see packed()
+		{
+			return std::holds_alternative<packed_ptr<interger_t>>(value)
+				|| std::holds_alternative<packed_ptr<float_t>>(value);
+		}
+
+		//the elements of a packed array of T (interger_t or float_t) for bulk reads, empty
+		//unless the array is stored that way. writes through the span keep the array packed
+		template<typename T>
+		std::span<const T> packed() const noexcept
+		{
+			if (auto numbers = std::get_if<packed_ptr<T>>(&value))
+				return { (*numbers)->data(), (*numbers)->size() };
+			return {};
+		}
+
+		template<typename T>
+		std::span<T> packed() noexcept
+		{
+			if (auto numbers = std::get_if<packed_ptr<T>>(&value))
+			{
+				(*numbers)->changed();
+				return { (*numbers)->data(), (*numbers)->size() };
+			}
+			return {};
+		}
+
+		//element index as T, read in place: unlike operator[] it never unpacks a packed array
+		template<typename T>
+		T get(size_type index) const
+		{
+			return withElement(index, [](const Basic_json& element) -> T
+			{
+				return element;
+			});
+		}
+
+		template<typename T>
+		operator T() const noexcept //implicit cast operation
+		{
+			if constexpr(std::is_convertible_v<T, object_t>)
+			{
+				return *std::get<object_ptr>(value);
+			}
+			else if constexpr(std::is_same_v<T, packed_t<interger_t>> || std::is_same_v<T, packed_t<float_t>>)
+			{
+				T numbers;
+				numbers.reserve(size());
+				forEachElement([&](const Basic_json& element)
+				{
+					numbers.push_back(element);
+				});
+				return numbers;
+			}
+			else if constexpr(std::is_convertible_v<T, array_t>)
+			{
+				if (is_packed())
+				{
+					array_t elements;
+					elements.reserve(size());
+					forEachElement([&](const Basic_json& element)
+					{
+						elements.push_back(element);
+					});
+					return elements;
+				}
+				return *std::get<array_ptr>(value);
+			}
+			else if constexpr(std::is_convertible_v<T, string_t>)
+			{
+				return *std::get<string_ptr>(value);
+			}
+			else if constexpr(std::is_same_v<T, interger_t>
+				|| std::is_same_v<T, float_t>
+				|| std::is_same_v<T, boolean_t>)
+			{
+				return std::get<T>(value);
+			}
+			else if constexpr(std::is_integral_v<T>)
+			{
+				return std::get<interger_t>(value);
+			}
+			else if constexpr(std::is_floating_point_v<T>)
+			{
+				return std::get<float_t>(value);
+			}
+			else if constexpr(std::is_convertible_v<T, boolean_t>)
+			{
+				return std::get<boolean_t>(value);
+			}
+			else
+			{
+				return nullptr;
+			}
+		}
+
+	public:
+		void push_back(const_reference element)
+		{
+			if (is_object()
+				&& element.is_array()
+				&& !element.is_packed()
+				&& element.size() == 2
+				&& element[0].is_string())
+				std::get<object_ptr>(value)
+				->emplace(
+					*std::get<string_ptr>(element[0].value), element[1]);
+			else if (is_array())
+			{
+				if (!pushPacked(element))
+					elements().push_back(element);
+			}
+			else
+				throw type_error("only object or array provide push_back");
+		}
+		void push_back(value_type&& element)
+		{
+			if (is_object()
+				&& element.is_array()
+				&& !element.is_packed()
+				&& element.size() == 2
+				&& element[0].is_string())
+				std::get<object_ptr>(value)
+				->emplace(
+					std::move(*std::get<string_ptr>(element[0].value)), std::move(element[1]));
+			else if (is_array())
+			{
+				if (!pushPacked(element))
+					elements().push_back(element);
+			}
+			else
+				throw type_error("only object or array provide push_back");
+		}
+		size_type size() const
+		{
+			if (is_object())
+				return std::get<object_ptr>(value)->size();
+			if (is_array())
+			{
+				if (auto array = std::get_if<array_ptr>(&value))
+					return (*array)->size();
+				if (auto ints = std::get_if<packed_ptr<interger_t>>(&value))
+					return (*ints)->size();
+				return std::get<packed_ptr<float_t>>(value)->size();
+			}
+			else
+				throw type_error("only object or array has size");
+		}
+	private:
+		//the generic elements of an array, unpacking packed numbers first: a reference to an
+		//element may be assigned any type, so handing one out needs real elements
+		array_t& elements()
+		{
+			if (auto array = std::get_if<array_ptr>(&value))
+				return **array;
+			return unpack();
+		}
+
+		array_t& unpack()
+		{
+			if (auto ints = std::get_if<packed_ptr<interger_t>>(&value))
+				value = unpacked(**ints);
+			else if (auto floats = std::get_if<packed_ptr<float_t>>(&value))
+				value = unpacked(**floats);
+			return *std::get<array_ptr>(value);
+		}
+
+		template<typename T>
+		static array_ptr unpacked(const packed_t<T>& numbers)
+		{
+			auto array = std::make_unique<array_t>();
+			array->reserve(numbers.size());
+			for (const auto number : numbers)
+				array->push_back(Basic_json(number));
+			return array;
+		}
+
+		bool pushPacked(const Basic_json& element) //false unless it stays packed
+		{
+			if (auto ints = std::get_if<packed_ptr<interger_t>>(&value); ints && element.is_interger())
+			{
+				(*ints)->changed();
+				(*ints)->push_back(std::get<interger_t>(element.value));
+			}
+			else if (auto floats = std::get_if<packed_ptr<float_t>>(&value); floats && element.is_float())
+			{
+				(*floats)->changed();
+				(*floats)->push_back(std::get<float_t>(element.value));
+			}
+			else
+				return false;
+			return true;
+		}
+
+		//f(element) for every element of an array, packed numbers are passed as temporaries
+		template<typename F>
+		void forEachElement(F&& f) const
+		{
+			if (auto array = std::get_if<array_ptr>(&value))
+				for (const auto& element : **array)
+					f(element);
+			else if (auto ints = std::get_if<packed_ptr<interger_t>>(&value))
+				for (const auto number : **ints)
+					f(Basic_json(number));
+			else
+				for (const auto number : *std::get<packed_ptr<float_t>>(value))
+					f(Basic_json(number));
+		}
+
+		const_reference elementAt(size_type index) const //a packed array stays packed
+		{
+			if (auto array = std::get_if<array_ptr>(&value))
+				return (**array)[index];
+			if (auto ints = std::get_if<packed_ptr<interger_t>>(&value))
+				return (*ints)->view()[index];
+			return std::get<packed_ptr<float_t>>(value)->view()[index];
+		}
+
+		template<typename F>
+		decltype(auto) withElement(size_type index, F&& f) const
+		{
+			if (auto array = std::get_if<array_ptr>(&value))
+				return f((**array)[index]);
+			if (auto ints = std::get_if<packed_ptr<interger_t>>(&value))
+				return f(Basic_json((**ints)[index]));
+			return f(Basic_json((*std::get<packed_ptr<float_t>>(value))[index]));
+		}
+
+		static Json_type packedKind(const Basic_json* first, size_t n) noexcept //Null unless it packs
+		{
+			const auto kind = n == 0 ? Json_type::Null : first->type;
+			if ((kind == Json_type::Interger || kind == Json_type::Float)
+				&& std::all_of(first + 1, first + n, [kind](const Basic_json& element)
+				{
+					return element.type == kind;
+				}))
+				return kind;
+			return Json_type::Null;
+		}
+
+		//gives an array built element by element the packed form the parser would have chosen
+		void pack()
+		{
+			const auto array = std::get_if<array_ptr>(&value);
+			if (!array)
+				return;
+			const auto kind = packedKind((*array)->data(), (*array)->size());
+			if (kind == Json_type::Interger)
+				value = packedFrom<interger_t>(**array);
+			else if (kind == Json_type::Float)
+				value = packedFrom<float_t>(**array);
+		}
+
+		template<typename T>
+		static packed_ptr<T> packedFrom(const array_t& elements)
+		{
+			auto numbers = std::make_unique<Packed<T>>();
+			numbers->reserve(elements.size());
+			for (const auto& element : elements)
+				numbers->push_back(std::get<T>(element.value));
+			return numbers;
+		}
+
+		class Lexer
+		{
+		public:
+
+			Token getToken()
+			{
+				skipSpace();
+				token_begin = pos;
+				switch (last_char)
+				{
+				case'{':
+				{
+					getChar();
+					return Token::Object_begin;
+				}
+				case'}':
+				{
+					getChar();
+					return Token::Object_end;
+				}
+				case'[':
+				{
+					getChar();
+					return Token::Array_begin;
+				}
+				case']':
+				{
+					getChar();
+					return Token::Array_end;
+				}
+				case':':
+				{
+					getChar();
+					return Token::Name_separator;
+				}
+				case',':
+				{
+					getChar();
+					return Token::Value_separator;
+				}
+				case'"':
+					return scanString();
+				case'-':[[fallthrough]];
+				case'0':
+				case'1':
+				case'2':
+				case'3':
+				case'4':
+				case'5':
+				case'6':
+				case'7':
+				case'8':
+				case'9':
+					return scanNumber();
+				case't': //true
+				case'f': //false
+					return scanBoolean();
+				case'n': //null
+					return scanNull();
+				case EOF: //a partial input may go on
+					return partial ? fail(Parse_errc::Unexpected_character) : Token::End;
+				default:
+					return fail(Parse_errc::Unexpected_character);
+				}
+			}
+
+			void getChar() //advance to the next char of the input
+			{
+				++pos;
+				last_char = pos < end ? static_cast<unsigned char>(*pos) : EOF;
+			}
+
+			size_t offset() const noexcept //of the current char
+			{
+				return static_cast<size_t>(std::min(pos, end) - begin);
+			}
+
+			size_t tokenOffset() const noexcept //of the first char of the last token
+			{
+				return static_cast<size_t>(token_begin - begin);
+			}
+
+			Parse_errc error() const noexcept //why the last Token::Error was returned
+			{
+				return error_code;
+			}
+
+			size_t errorOffset() const noexcept
+			{
+				return error_offset;
+			}
+
+			bool atEnd() const noexcept
+			{
+				return last_char == EOF;
+			}
+
+			void skipSpace()
+			{
+				while (std::isspace(last_char))
+				{
+					getChar();
+				}
+			}
+
+			template<typename T>
+			decltype(auto) getValue() noexcept
+			{
+				if constexpr(std::is_same_v<T, string_t>)
+					return (string_value);
+				else if constexpr(std::is_same_v<T, interger_t>)
+					return interger_value;
+				else
+					return float_value;
+			}
+
+			//more_input: s is only a prefix, a token running into its end may not be complete yet
+			void setInput(std::string_view s, size_t max_string = std::numeric_limits<size_t>::max(),
+				bool more_input = false) noexcept
+			{
+				//the input must outlive the parse
+				begin = pos = token_begin = s.data();
+				end = s.data() + s.size();
+				last_char = pos < end ? static_cast<unsigned char>(*pos) : EOF;
+				max_string_length = max_string;
+				partial = more_input;
+				starving = false;
+			}
+
+			void extend(std::string_view s, bool more_input) noexcept //s starts with the input so far
+			{
+				const auto at = offset();
+				token_begin = s.data() + tokenOffset();
+				begin = s.data();
+				pos = begin + at;
+				end = s.data() + s.size();
+				last_char = pos < end ? static_cast<unsigned char>(*pos) : EOF;
+				partial = more_input;
+			}
+
+			bool starved() const noexcept //the last Token::Error ran into the end of a partial input
+			{
+				return starving;
+			}
+
+			void rewind() noexcept //to the start of the last token, to scan it again once extended
+			{
+				pos = token_begin;
+				last_char = pos < end ? static_cast<unsigned char>(*pos) : EOF;
+				starving = false;
+			}
+
+			bool partialInput() const noexcept
+			{
+				return partial;
+			}
+
+			int peek() //the first char of the next token
+			{
+				skipSpace();
+				return last_char;
+			}
+
+			//steps over one value without building it: tokens and grammar are checked as a parse
+			//checks them, but strings are only scanned for their end and no node is made
+			Token skipValue()
+			{
+				enum class Expect { Value, Value_or_end, Name_or_end, Name_separator, After_value };
+				closers.clear();
+				const char* const start = pos;
+				auto expect = Expect::Value;
+				for (;;)
+				{
+					const auto token = skipToken();
+					if (token == Token::Error)
+					{
+						if (starving) //rewind() goes back over the whole value
+							token_begin = start;
+						return token;
+					}
+					switch (expect)
+					{
+					case Expect::Name_or_end:
+						if (token == Token::String)
+						{
+							expect = Expect::Name_separator;
+							continue;
+						}
+						if (token != Token::Object_end)
+							return unexpected(Parse_errc::Name_expected);
+						break;
+					case Expect::Name_separator:
+						if (token != Token::Name_separator)
+							return unexpected(Parse_errc::Name_separator_expected);
+						expect = Expect::Value;
+						continue;
+					case Expect::After_value:
+					{
+						const auto is_object = closers.back() == '}';
+						if (token == Token::Value_separator)
+						{
+							expect = is_object ? Expect::Name_or_end : Expect::Value_or_end;
+							continue;
+						}
+						if (token != (is_object ? Token::Object_end : Token::Array_end))
+							return unexpected(is_object ? Parse_errc::Object_end_expected : Parse_errc::Array_end_expected);
+						break;
+					}
+					case Expect::Value_or_end:
+						if (token == Token::Array_end)
+							break;
+						[[fallthrough]];
+					case Expect::Value:
+						switch (token)
+						{
+						case Token::Object_begin:
+							closers.push_back('}');
+							expect = Expect::Name_or_end;
+							continue;
+						case Token::Array_begin:
+							closers.push_back(']');
+							expect = Expect::Value_or_end;
+							continue;
+						case Token::String:
+						case Token::Interger:
+						case Token::Float:
+						case Token::True:
+						case Token::False:
+						case Token::Null:
+							if (closers.empty())
+								return Token::Null;
+							expect = Expect::After_value;
+							continue;
+						default:
+							return unexpected(Parse_errc::Value_expected);
+						}
+					}
+					closers.pop_back(); //token closed the innermost container
+					if (closers.empty())
+						return Token::Null;
+					expect = Expect::After_value;
+				}
+			}
+
+		private:
+			const char* begin = nullptr;
+			const char* pos = nullptr;
+			const char* end = nullptr;
+			const char* token_begin = nullptr;
+			int last_char = EOF;
+			Parse_errc error_code = Parse_errc::None;
+			size_t error_offset = 0;
+			size_t max_string_length = std::numeric_limits<size_t>::max();
+			bool partial = false;
+			bool starving = false;
+			string_t string_value; //reused by every string token
+			std::vector<char> closers; //of the containers skipValue() is inside, reused between values
+			interger_t interger_value{};
+			float_t float_value{};
+
+			Token fail(Parse_errc code) noexcept
+			{
+				error_code = code;
+				error_offset = offset();
+				starving = partial && pos >= end;
+				return Token::Error;
+			}
+
+			Token failToken(Parse_errc code) noexcept //at the start of the token being scanned
+			{
+				fail(code);
+				error_offset = tokenOffset();
+				return Token::Error;
+			}
+
+			Token unexpected(Parse_errc code) noexcept //the last token is whole but does not fit here
+			{
+				error_code = code;
+				error_offset = tokenOffset();
+				starving = false;
+				return Token::Error;
+			}
+
+			Token skipToken() //getToken() without copying a string
+			{
+				skipSpace();
+				if (last_char != '"')
+					return getToken();
+				token_begin = pos;
+				size_t length = 0; //as scanString() counts it, an escape pair is one char
+				getChar();
+				while (last_char != '"')
+				{
+					if (last_char == EOF)
+						return fail(Parse_errc::Unterminated_string);
+					if (last_char == '\\')
+					{
+						getChar();
+						if (last_char == EOF)
+							continue;
+						++length;
+						getChar();
+						continue;
+					}
+					const char* run = pos;
+					while (pos < end && *pos != '"' && *pos != '\\')
+						++pos;
+					length += pos - run;
+					--pos;
+					getChar();
+				}
+				if (length > max_string_length)
+					return failToken(Parse_errc::String_too_long);
+				getChar();
+				return Token::String;
+			}
+
+			Token scanString()
+			{
+				string_value.clear();
+				getChar();
+				while (last_char != '"')
+				{
+					if (last_char == EOF)
+						return fail(Parse_errc::Unterminated_string);
+					if (last_char == '\\') //keep the escaped char as is
+					{
+						getChar();
+						if (last_char == EOF)
+							continue;
+						string_value += static_cast<char>(last_char);
+						getChar();
+						continue;
+					}
+					const char* run = pos; //copy plain chars in one go
+					while (pos < end && *pos != '"' && *pos != '\\')
+						++pos;
+					string_value.append(run, pos - run);
+					if (string_value.size() > max_string_length) //stop before copying the rest
+						break;
+					--pos;
+					getChar();
+				}
+				if (string_value.size() > max_string_length)
+					return failToken(Parse_errc::String_too_long);
+				getChar();
+				return Token::String;
+			}
+
+			Token scanNumber()
+			{
+				const char* start = pos;
+				bool is_float = false;
+				while (std::isdigit(last_char)
+					|| last_char == '.'
+					|| last_char == '+'
+					|| last_char == '-'
+					|| last_char == 'e'
+					|| last_char == 'E')
+				{
+					if (last_char == '.' || last_char == 'e' || last_char == 'E')
+						is_float = true;
+					getChar();
+				}
+				if (partial && pos >= end) //the number may go on in the next chunk
+					return failToken(Parse_errc::Invalid_number);
+				if (is_float)
+				{
+					if (const auto result = std::from_chars(start, pos, float_value);
+						result.ptr != pos || result.ec != std::errc()) //out of range keeps no value
+						return failToken(Parse_errc::Invalid_number);
+					return Token::Float;
+				}
+				else
+				{
+					if (const auto result = std::from_chars(start, pos, interger_value);
+						result.ptr != pos || result.ec != std::errc()) //out of range keeps no value
+						return failToken(Parse_errc::Invalid_number);
+					return Token::Interger;
+				}
+			}
+
+			Token scanBoolean()
+			{
+				using namespace std::string_view_literals;
+				static constexpr auto true_literal = "true"sv;
+				static constexpr auto false_literal = "false"sv;
+				if (last_char == 't')
+				{
+					for (const auto& c : true_literal)
+					{
+						if (last_char == c)
+							getChar();
+						else
+							return failToken(Parse_errc::Invalid_literal);
+					}
+					return Token::True;
+				}
+				else //last_char == 'f'
+				{
+					for (const auto& c : false_literal)
+					{
+						if (last_char == c)
+							getChar();
+						else
+							return failToken(Parse_errc::Invalid_literal);
+					}
+					return Token::False;
+				}
+			}
+
+			Token scanNull()
+			{
+				using namespace std::string_view_literals;
+				static constexpr auto null_literal = "null"sv;
+				for (const auto& c : null_literal)
+				{
+					if (last_char == c)
+						getChar();
+					else
+						return failToken(Parse_errc::Invalid_literal);
+				}
+				return Token::Null;
+			}
+		};
+
+	public:
+		class Parser;
+		class Parse_task;
+
+		class Document //a parse target whose node storage survives clear() for the next parse
+		{
+		public:
+			reference root() noexcept
+			{
+				return root_value;
+			}
+
+			const_reference root() const noexcept
+			{
+				return root_value;
+			}
+
+			void clear() //hand every node of the current tree back to the free lists
+			{
+				recycle(root_value);
+				root_value = Basic_json();
+			}
+
+		private:
+			friend class Parser;
+
+			using member_node = typename object_t::node_type;
+
+			static constexpr size_t classes = std::numeric_limits<size_t>::digits + 2;
+
+			Basic_json root_value;
+			JASOON_STAT(size_t allocated = 0;) //acquisitions the free lists could not serve
+			//free lists by size class: a request of class k is only served by storage that
+			//already holds 2^k, so the same payload shapes never reallocate, whatever the order
+			std::array<std::vector<object_ptr>, classes> objects;
+			std::array<std::vector<array_ptr>, classes> arrays;
+			std::array<std::vector<string_ptr>, classes> strings;
+			std::array<std::vector<packed_ptr<interger_t>>, classes> packed_ints;
+			std::array<std::vector<packed_ptr<float_t>>, classes> packed_floats;
+			std::vector<member_node> members; //names are Keys, so any node fits any member
+
+			static size_t ceilLog2(size_t n) noexcept
+			{
+				size_t k = 0;
+				while (k + 1 < classes && (size_t(1) << k) < n)
+					++k;
+				return k;
+			}
+
+			static size_t floorLog2(size_t n) noexcept
+			{
+				size_t k = 0;
+				while (n >>= 1)
+					++k;
+				return k;
+			}
+
+			static size_t smallString() noexcept //capacity of an empty string_t, e.g. sso
+			{
+				static const size_t small = string_t().capacity();
+				return small;
+			}
+
+			static size_t stringClass(size_t length) noexcept
+			{
+				return length <= smallString() ? 0 : ceilLog2(length);
+			}
+
+			static size_t storedStringClass(const string_t& s) noexcept
+			{
+				return s.capacity() <= smallString() ? 0 : floorLog2(s.capacity());
+			}
+
+			static size_t arrayClass(size_t n) noexcept
+			{
+				return n == 0 ? 0 : 1 + ceilLog2(n);
+			}
+
+			static size_t objectClass(size_t n) noexcept
+			{
+				return ceilLog2(n);
+			}
+
+			static void reserveString(string_t& s, size_t length)
+			{
+				if (const auto k = stringClass(length))
+					s.reserve(size_t(1) << k);
+			}
+
+			template<typename T>
+			static T take(std::array<std::vector<T>, classes>& free_lists, size_t k)
+			{
+				//storage of class k holds at least 2^k, any larger class serves as well
+				for (; k < classes; ++k)
+				{
+					auto& free_list = free_lists[k];
+					if (!free_list.empty())
+					{
+						auto item = std::move(free_list.back());
+						free_list.pop_back();
+						return item;
+					}
+				}
+				return T();
+			}
+
+			object_ptr acquireObject(size_t n)
+			{
+				const auto k = objectClass(n);
+				if (auto ptr = take(objects, k))
+					return ptr;
+				JASOON_STAT(++allocated);
+				auto ptr = std::make_unique<object_t>();
+				ptr->reserve(size_t(1) << k);
+				return ptr;
+			}
+
+			array_ptr acquireArray(size_t n)
+			{
+				const auto k = arrayClass(n);
+				if (auto ptr = take(arrays, k))
+					return ptr;
+				JASOON_STAT(++allocated);
+				auto ptr = std::make_unique<array_t>();
+				if (k != 0)
+					ptr->reserve(size_t(1) << (k - 1));
+				return ptr;
+			}
+
+			template<typename T>
+			auto& packedLists() noexcept
+			{
+				if constexpr (std::is_same_v<T, interger_t>)
+					return packed_ints;
+				else
+					return packed_floats;
+			}
+
+			template<typename T>
+			packed_ptr<T> acquirePacked(size_t n)
+			{
+				const auto k = arrayClass(n);
+				if (auto ptr = take(packedLists<T>(), k))
+					return ptr;
+				JASOON_STAT(++allocated);
+				auto ptr = std::make_unique<Packed<T>>();
+				if (k != 0)
+					ptr->reserve(size_t(1) << (k - 1));
+				return ptr;
+			}
+
+			template<typename T>
+			void releasePacked(packed_ptr<T>& ptr)
+			{
+				if (!ptr)
+					return;
+				ptr->changed();
+				ptr->clear();
+				const auto k = ptr->capacity() == 0 ? 0 : 1 + floorLog2(ptr->capacity());
+				packedLists<T>()[k].push_back(std::move(ptr));
+			}
+
+			string_ptr acquireString(size_t length)
+			{
+				if (auto ptr = take(strings, stringClass(length)))
+					return ptr;
+				JASOON_STAT(++allocated);
+				auto ptr = std::make_unique<string_t>();
+				reserveString(*ptr, length);
+				return ptr;
+			}
+
+			member_node acquireMember()
+			{
+				if (members.empty())
+					return member_node();
+				auto member = std::move(members.back());
+				members.pop_back();
+				return member;
+			}
+
+			void releaseMember(member_node&& member)
+			{
+				recycle(member.mapped());
+				members.push_back(std::move(member));
+			}
+
+			void recycle(Basic_json& node)
+			{
+				switch (node.type)
+				{
+				case Json_type::Object:
+				{
+					auto& ptr = std::get<object_ptr>(node.value);
+					if (!ptr) //moved-from
+						break;
+					while (!ptr->empty())
+						releaseMember(ptr->extract(ptr->begin()));
+					objects[floorLog2(ptr->bucket_count())].push_back(std::move(ptr));
+					break;
+				}
+				case Json_type::Array:
+				{
+					if (auto ints = std::get_if<packed_ptr<interger_t>>(&node.value))
+					{
+						releasePacked(*ints);
+						break;
+					}
+					if (auto floats = std::get_if<packed_ptr<float_t>>(&node.value))
+					{
+						releasePacked(*floats);
+						break;
+					}
+					auto& ptr = std::get<array_ptr>(node.value);
+					if (!ptr)
+						break;
+					for (auto& element : *ptr)
+						recycle(element);
+					ptr->clear();
+					const auto k = ptr->capacity() == 0 ? 0 : 1 + floorLog2(ptr->capacity());
+					arrays[k].push_back(std::move(ptr));
+					break;
+				}
+				case Json_type::String:
+				{
+					auto& ptr = std::get<string_ptr>(node.value);
+					if (!ptr)
+						break;
+					ptr->clear();
+					const auto k = storedStringClass(*ptr);
+					strings[k].push_back(std::move(ptr));
+					break;
+				}
+				default:
+					break;
+				}
+				node.type = Json_type::Null;
+			}
+		};
+
+		//a compiled subset of JSON Schema: type, enum, required, properties, items, minimum,
+		//maximum, exclusiveMinimum, exclusiveMaximum, minLength, maxLength, minItems and maxItems.
+		//checks a Basic_json with validate(), or a parse as it goes with Parser::parse(s, schema)
+		class Schema
+		{
+		public:
+			explicit Schema(const Basic_json& schema) //input_error if it uses anything else
+			{
+				compile(schema);
+			}
+
+			Schema_error validate(const Basic_json& j) const
+			{
+				Schema_error error;
+				validateNode(0, j, error);
+				return error;
+			}
+
+			bool is_valid(const Basic_json& j) const
+			{
+				return !validate(j);
+			}
+		private:
+			friend class Parser;
+
+			static constexpr size_t none = std::numeric_limits<size_t>::max(); //unconstrained
+
+			enum Type_bit : unsigned
+			{
+				Null_bit = 1, Boolean_bit = 2, Integer_bit = 4, Number_bit = 8,
+				String_bit = 16, Array_bit = 32, Object_bit = 64, Any = 127
+			};
+
+			struct Node
+			{
+				unsigned types = Any;
+				std::vector<Basic_json> enum_values;
+				bool has_enum = false;
+				std::vector<key_t> required;
+				std::unordered_map<key_t, size_t, Key_hash, Key_equal> properties; //to node index
+				size_t items = none;
+				double minimum = -std::numeric_limits<double>::infinity();
+				double maximum = std::numeric_limits<double>::infinity();
+				double exclusive_minimum = -std::numeric_limits<double>::infinity(); //kept apart so both bounds apply
+				double exclusive_maximum = std::numeric_limits<double>::infinity();
+				size_t min_length = 0;
+				size_t max_length = std::numeric_limits<size_t>::max();
+				size_t min_items = 0;
+				size_t max_items = std::numeric_limits<size_t>::max();
+			};
+
+			std::vector<Node> nodes; //nodes[0] is the root
+
+			[[noreturn]] static void invalid(const char* message)
+			{
+				throw input_error(std::string("invalid schema: ") + message);
+			}
+
+			static size_t count(const Basic_json& j)
+			{
+				if (!j.is_interger() || static_cast<interger_t>(j) < 0)
+					invalid("a count must be a non-negative integer");
+				return static_cast<size_t>(static_cast<interger_t>(j));
+			}
+
+			static double number(const Basic_json& j)
+			{
+				if (j.is_interger())
+					return static_cast<double>(static_cast<interger_t>(j));
+				if (j.is_float())
+					return static_cast<double>(static_cast<float_t>(j));
+				invalid("a bound must be a number");
+			}
+
+			static unsigned typeBit(std::string_view name)
+			{
+				static constexpr std::pair<std::string_view, unsigned> names[] = {
+					{ "null", Null_bit }, { "boolean", Boolean_bit }, { "integer", Integer_bit },
+					{ "number", Number_bit | Integer_bit }, { "string", String_bit },
+					{ "array", Array_bit }, { "object", Object_bit } };
+				for (const auto& [type_name, bit] : names)
+					if (type_name == name)
+						return bit;
+				invalid("unknown type");
+			}
+
+			static unsigned typeOf(const Basic_json& j) noexcept
+			{
+				switch (j.type)
+				{
+				case Json_type::Object:
+					return Object_bit;
+				case Json_type::Array:
+					return Array_bit;
+				case Json_type::String:
+					return String_bit;
+				case Json_type::Interger:
+					return Integer_bit;
+				case Json_type::Float:
+				{
+					const auto f = std::get<float_t>(j.value);
+					return std::floor(f) == f ? Integer_bit : Number_bit; //1.0 is an integer
+				}
+				case Json_type::Boolean:
+					return Boolean_bit;
+				default:
+					return Null_bit;
+				}
+			}
+
+			size_t compile(const Basic_json& schema) //returns the index of the new node
+			{
+				const auto index = nodes.size();
+				nodes.emplace_back();
+				if (schema.is_boolean()) //true accepts anything, false nothing
+				{
+					if (!static_cast<boolean_t>(schema))
+						nodes[index].types = 0;
+					return index;
+				}
+				if (!schema.is_object())
+					invalid("a schema must be an object or a boolean");
+				for (const auto& [keyword, argument] : *std::get<object_ptr>(schema.value))
+				{
+					const std::string_view name = keyword;
+					auto& node = nodes[index]; //compile() below may move nodes
+					if (name == "type")
+					{
+						node.types = 0;
+						if (argument.is_string())
+							node.types = typeBit(*std::get<string_ptr>(argument.value));
+						else if (argument.is_array())
+							argument.forEachElement([&](const Basic_json& type)
+							{
+								if (!type.is_string())
+									invalid("type must be a string or an array of strings");
+								node.types |= typeBit(*std::get<string_ptr>(type.value));
+							});
+						else
+							invalid("type must be a string or an array of strings");
+					}
+					else if (name == "enum")
+					{
+						if (!argument.is_array())
+							invalid("enum must be an array");
+						node.has_enum = true;
+						argument.forEachElement([&](const Basic_json& element)
+						{
+							node.enum_values.push_back(element);
+						});
+					}
+					else if (name == "required")
+					{
+						if (!argument.is_array())
+							invalid("required must be an array of strings");
+						argument.forEachElement([&](const Basic_json& member)
+						{
+							if (!member.is_string())
+								invalid("required must be an array of strings");
+							node.required.emplace_back(*std::get<string_ptr>(member.value));
+						});
+					}
+					else if (name == "properties")
+					{
+						if (!argument.is_object())
+							invalid("properties must be an object");
+						for (const auto& [member, member_schema] : *std::get<object_ptr>(argument.value))
+						{
+							const auto child = compile(member_schema);
+							nodes[index].properties.emplace(member, child);
+						}
+					}
+					else if (name == "items")
+					{
+						const auto child = compile(argument);
+						nodes[index].items = child;
+					}
+					else if (name == "minimum")
+						node.minimum = number(argument);
+					else if (name == "maximum")
+						node.maximum = number(argument);
+					else if (name == "exclusiveMinimum")
+						node.exclusive_minimum = number(argument);
+					else if (name == "exclusiveMaximum")
+						node.exclusive_maximum = number(argument);
+					else if (name == "minLength")
+						node.min_length = count(argument);
+					else if (name == "maxLength")
+						node.max_length = count(argument);
+					else if (name == "minItems")
+						node.min_items = count(argument);
+					else if (name == "maxItems")
+						node.max_items = count(argument);
+					else if (name != "$schema" && name != "$id" && name != "$comment" && name != "title"
+						&& name != "description" && name != "default" && name != "examples")
+						invalid("unsupported keyword"); //e.g. pattern or $ref, never skipped silently
+				}
+				return index;
+			}
+
+			bool allows(size_t index, unsigned type) const noexcept
+			{
+				return index == none || (nodes[index].types & type) != 0;
+			}
+
+			//the constraints on j itself; its members and items are checked on their own
+			Schema_errc check(size_t index, const Basic_json& j) const
+			{
+				if (index == none)
+					return Schema_errc::None;
+				const auto& node = nodes[index];
+				if (!(node.types & typeOf(j))) //"number" includes the integer bit
+					return Schema_errc::Type;
+				if (node.has_enum
+					&& std::find(node.enum_values.begin(), node.enum_values.end(), j) == node.enum_values.end())
+					return Schema_errc::Enum;
+				switch (j.type)
+				{
+				case Json_type::Interger:
+				case Json_type::Float:
+				{
+					const auto n = j.is_interger()
+						? static_cast<double>(std::get<interger_t>(j.value))
+						: static_cast<double>(std::get<float_t>(j.value));
+					if (n < node.minimum || n <= node.exclusive_minimum)
+						return Schema_errc::Minimum;
+					if (n > node.maximum || n >= node.exclusive_maximum)
+						return Schema_errc::Maximum;
+					break;
+				}
+				case Json_type::String:
+				{
+					const auto& s = *std::get<string_ptr>(j.value);
+					//lengths count code points: every byte but utf-8 continuation bytes
+					const auto length = static_cast<size_t>(std::count_if(s.begin(), s.end(), [](char c)
+					{
+						return (static_cast<unsigned char>(c) & 0xc0) != 0x80;
+					}));
+					if (length < node.min_length)
+						return Schema_errc::Min_length;
+					if (length > node.max_length)
+						return Schema_errc::Max_length;
+					break;
+				}
+				case Json_type::Array:
+					if (j.size() < node.min_items)
+						return Schema_errc::Min_items;
+					if (j.size() > node.max_items)
+						return Schema_errc::Max_items;
+					break;
+				case Json_type::Object:
+				{
+					const auto& members = *std::get<object_ptr>(j.value);
+					for (const auto& name : node.required)
+						if (members.find(name) == members.end())
+							return Schema_errc::Required;
+					break;
+				}
+				default:
+					break;
+				}
+				return Schema_errc::None;
+			}
+
+			size_t property(size_t index, const key_t& name) const
+			{
+				if (index == none)
+					return none;
+				const auto& properties = nodes[index].properties;
+				const auto it = properties.find(name);
+				return it == properties.end() ? none : it->second;
+			}
+
+			size_t items(size_t index) const noexcept
+			{
+				return index == none ? none : nodes[index].items;
+			}
+
+			static void escapePointer(std::string& path, std::string_view segment)
+			{
+				for (const auto c : segment)
+				{
+					if (c == '~')
+						path += "~0";
+					else if (c == '/')
+						path += "~1";
+					else
+						path += c;
+				}
+			}
+
+			//the path is put together on the way out, so only a failure pays for it
+			bool validateNode(size_t index, const Basic_json& j, Schema_error& error) const
+			{
+				if (index == none)
+					return true;
+				if (const auto code = check(index, j); code != Schema_errc::None)
+				{
+					error.code = code;
+					return false;
+				}
+				const auto& node = nodes[index];
+				const auto prepend = [&](std::string_view segment)
+				{
+					std::string path = "/";
+					escapePointer(path, segment);
+					error.path.insert(0, path);
+					return false;
+				};
+				if (j.is_object() && !node.properties.empty())
+				{
+					const auto& members = *std::get<object_ptr>(j.value);
+					for (const auto& [name, child] : node.properties)
+					{
+						const auto it = members.find(name);
+						if (it != members.end() && !validateNode(child, it->second, error))
+							return prepend(name);
+					}
+				}
+				else if (j.is_array() && node.items != none)
+				{
+					for (size_type i = 0; i < j.size(); ++i)
+					{
+						const auto valid = j.withElement(i, [&](const Basic_json& element)
+						{
+							return validateNode(node.items, element, error);
+						});
+						if (!valid)
+							return prepend(std::to_string(i));
+					}
+				}
+				return true;
+			}
+		};
+
+		//the paths a parse keeps, e.g. { "events.*.name", "performances[*].prices" }: names are
+		//separated by '.', and '*' or '[*]' stands for every member or element
+		class Projection
+		{
+		public:
+			Projection(std::initializer_list<std::string_view> paths) : Projection(paths.begin(), paths.end()) {}
+
+			template<typename It>
+			Projection(It first, It last) //input_error for a malformed path
+			{
+				nodes.emplace_back();
+				for (; first != last; ++first)
+					add(*first);
+				spread(0);
+			}
+		private:
+			friend class Parser;
+
+			static constexpr size_t none = std::numeric_limits<size_t>::max(); //nothing below is kept
+			static constexpr size_t all = none - 1; //everything below is kept
+
+			struct Node
+			{
+				std::unordered_map<key_t, size_t, Key_hash, Key_equal> members; //to node index
+				size_t any = none; //'*'
+				bool whole = false; //a path ends here
+			};
+
+			std::vector<Node> nodes; //nodes[0] is the root
+
+			[[noreturn]] static void invalid(const char* message)
+			{
+				throw input_error(std::string("invalid path: ") + message);
+			}
+
+			void add(std::string_view path)
+			{
+				size_t index = 0;
+				for (size_t i = 0;;)
+				{
+					if (i == path.size())
+						invalid("empty name");
+					if (path[i] == '[')
+					{
+						if (path.substr(i, 3) != "[*]")
+							invalid("only [*] may be bracketed");
+						index = anyChild(index);
+						i += 3;
+					}
+					else
+					{
+						const auto stop = std::min(path.find_first_of(".[", i), path.size());
+						const auto name = path.substr(i, stop - i);
+						if (name.empty())
+							invalid("empty name");
+						index = name == "*" ? anyChild(index) : memberChild(index, name);
+						i = stop;
+					}
+					if (i == path.size())
+						break;
+					if (path[i] == '.')
+						++i;
+				}
+				nodes[index].whole = true;
+			}
+
+			size_t memberChild(size_t index, std::string_view name)
+			{
+				if (const auto it = nodes[index].members.find(name); it != nodes[index].members.end())
+					return it->second;
+				nodes.emplace_back(); //may move nodes
+				nodes[index].members.emplace(key_t(name), nodes.size() - 1);
+				return nodes.size() - 1;
+			}
+
+			size_t anyChild(size_t index)
+			{
+				if (nodes[index].any == none)
+				{
+					nodes.emplace_back();
+					nodes[index].any = nodes.size() - 1;
+				}
+				return nodes[index].any;
+			}
+
+			void spread(size_t index) //a '*' also applies to the members named beside it
+			{
+				std::vector<size_t> children;
+				for (const auto& member : nodes[index].members)
+					children.push_back(member.second);
+				const auto any = nodes[index].any;
+				for (const auto child : children)
+				{
+					if (any != none)
+						unite(child, any);
+					spread(child);
+				}
+				if (any != none)
+					spread(any);
+			}
+
+			void unite(size_t to, size_t from) //adds the paths below from to those below to
+			{
+				if (nodes[from].whole)
+					nodes[to].whole = true;
+				std::vector<std::pair<key_t, size_t>> members(nodes[from].members.begin(), nodes[from].members.end());
+				for (const auto& [name, child] : members)
+					unite(memberChild(to, name), child);
+				if (const auto any = nodes[from].any; any != none)
+					unite(anyChild(to), any);
+			}
+
+			size_t resolve(size_t index) const noexcept
+			{
+				return index != none && nodes[index].whole ? all : index;
+			}
+
+			size_t member(size_t index, std::string_view name) const
+			{
+				if (index == all)
+					return all;
+				const auto& members = nodes[index].members;
+				const auto it = members.find(name);
+				return resolve(it == members.end() ? nodes[index].any : it->second);
+			}
+
+			size_t items(size_t index) const noexcept
+			{
+				return index == all ? all : resolve(nodes[index].any);
+			}
+		};
+
+		class Parser
+		{
+		public:
+			Parser() = default;
+
+			explicit Parser(const Parse_limits& limits) : parse_limits(limits) {}
+
+			Basic_json parse(std::string_view s)
+			{
+				Basic_json root;
+				if (const auto e = try_parse(s, root))
+					throw input_error(e);
+				return root;
+			}
+
+			Basic_json parse(const string_t& s, InputMode mode)
+			{
+				Basic_json root;
+				if (const auto e = try_parse(s, mode, root))
+					throw input_error(e);
+				return root;
+			}
+
+			void parse(std::string_view s, Document& doc) //refills doc, reusing its nodes
+			{
+				if (const auto e = try_parse(s, doc))
+					throw input_error(e);
+			}
+
+			void parse(const string_t& s, InputMode mode, Document& doc)
+			{
+				if (const auto e = try_parse(s, mode, doc))
+					throw input_error(e);
+			}
+
+			//the same parses without exceptions for malformed input: the error is returned and
+			//root is left unspecified. only allocation failures still throw
+			Parse_error try_parse(std::string_view s, Basic_json& root)
+			{
+				resetStats();
+				return outcome(parseRoot(s, root));
+			}
+
+			Parse_error try_parse(const string_t& s, InputMode mode, Basic_json& root)
+			{
+				resetStats();
+				std::string_view text;
+				return outcome(input(s, mode, text) && parseRoot(text, root));
+			}
+
+			Parse_error try_parse(std::string_view s, Document& doc)
+			{
+				resetStats();
+				return outcome(fill(s, doc));
+			}
+
+			Parse_error try_parse(const string_t& s, InputMode mode, Document& doc)
+			{
+				resetStats();
+				std::string_view text;
+				return outcome(input(s, mode, text) && fill(text, doc));
+			}
+
+			const Parse_stats& stats() const noexcept //of the last parse, zero unless JASOON_ENABLE_STATS
+			{
+				return parse_stats;
+			}
+
+			const Parse_limits& limits() const noexcept
+			{
+				return parse_limits;
+			}
+
+			void set_limits(const Parse_limits& limits) noexcept //applies from the next parse on
+			{
+				parse_limits = limits;
+			}
+
+			//member names are interned here for the parser's lifetime; keys taken from it
+			//find parsed members by pointer. set_capacity(0) turns interning off
+			Key_table& keys() noexcept
+			{
+				return key_table;
+			}
+
+			//validates while parsing: fails with Parse_errc::Schema_mismatch at the first value the
+			//schema rejects, schema_error() tells why and where
+			Basic_json parse(std::string_view s, const Schema& schema)
+			{
+				Basic_json root;
+				if (const auto e = try_parse(s, schema, root))
+					throw input_error(e);
+				return root;
+			}
+
+			Parse_error try_parse(std::string_view s, const Schema& schema, Basic_json& root)
+			{
+				Schema_guard guard{ *this, schema };
+				return try_parse(s, root);
+			}
+
+			const Schema_error& schema_error() const noexcept //of the last Parse_errc::Schema_mismatch
+			{
+				return schema_failure;
+			}
+
+			//keeps only the values at the projection's paths, the rest is skipped by the lexer
+			Basic_json parse(std::string_view s, const Projection& projection)
+			{
+				Basic_json root;
+				if (const auto e = try_parse(s, projection, root))
+					throw input_error(e);
+				return root;
+			}
+
+			Parse_error try_parse(std::string_view s, const Projection& projection, Basic_json& root)
+			{
+				Projection_guard guard{ *this, projection };
+				return try_parse(s, root);
+			}
+
+			//parses a document arriving in chunks without blocking, e.g. from an event loop: the task
+			//waits for task.feed() and task.finish(), and each resume() parses about budget bytes of
+			//what it has before suspending until the next tick. the parser must outlive the task and
+			//must not parse anything else until it is done
+			Parse_task parse_async(size_t budget = 64 * 1024)
+			{
+				resetStats();
+				stream_buffer.clear();
+				stream_open = true;
+				text = stream_buffer;
+				start(stream_buffer, false, true);
+				Basic_json root;
+				for (;;)
+				{
+					if (stream_buffer.size() > parse_limits.max_document_size)
+					{
+						fail(Parse_errc::Document_too_large);
+						throw input_error(parse_error);
+					}
+					switch (run(root, budget))
+					{
+					case Step::Done:
+						JASOON_STAT(parse_stats.bytes += stream_buffer.size());
+						co_return root;
+					case Step::Failed:
+						throw input_error(parse_error);
+					case Step::Yield:
+						co_await typename Parse_task::Suspend{ false };
+						break;
+					case Step::Need_input:
+						co_await typename Parse_task::Suspend{ true };
+						break;
+					}
+				}
+			}
+
+			//any type, nothing after it. depth containers enclose it, for the depth limit
+			Parse_error parseElement(std::string_view s, Basic_json& element, size_t depth = 0)
+			{
+				outer_depth = depth;
+				const auto e = outcome(parseValue(s, true, element));
+				outer_depth = 0;
+				return e;
+			}
+		private:
+			friend class Parse_task;
+
+			enum class Step //where run() stopped
+			{
+				Done,
+				Failed,
+				Yield,     //spent its budget
+				Need_input //at the end of a partial input
+			};
+
+			struct Pool_guard
+			{
+				Pool_guard(Parser& p, Document& doc) noexcept : parser(p)
+				{
+					parser.pool = &doc;
+				}
+				~Pool_guard()
+				{
+					parser.pool = nullptr;
+				}
+				Parser& parser;
+			};
+
+			struct Frame //an array or object still open
+			{
+				bool is_object;
+				size_t first_value; //its values are values[first_value, values.size())
+				size_t first_name;  //and the names of an object are names[first_name, name_count)
+				size_t schema_node; //constraining its members or items, Schema::none if nothing
+				size_t selection;   //projection node of the container itself
+			};
+
+			enum class State //what the next token may be
+			{
+				Root,           //'{' or '['
+				Value,          //any value
+				Value_or_end,   //a value or ']'
+				Name_or_end,    //a member name or '}'
+				Name_separator, //':'
+				After_value,    //',' or the end of the innermost container
+				After_root      //nothing but white space
+			};
+
+			struct Schema_guard
+			{
+				Schema_guard(Parser& p, const Schema& s) noexcept : parser(p)
+				{
+					parser.schema = &s;
+				}
+				~Schema_guard()
+				{
+					parser.schema = nullptr;
+				}
+				Parser& parser;
+			};
+
+			struct Projection_guard
+			{
+				Projection_guard(Parser& p, const Projection& projection) noexcept : parser(p)
+				{
+					parser.projection = &projection;
+				}
+				~Projection_guard()
+				{
+					parser.projection = nullptr;
+				}
+				Parser& parser;
+			};
+
+			void feed(std::string_view chunk)
+			{
+				if (!stream_open)
+					throw std::logic_error("parse_async: input fed after finish()");
+				stream_buffer.append(chunk.data(), chunk.size()); //may move, the lexer follows
+				text = stream_buffer;
+				lexer.extend(stream_buffer, true);
+			}
+
+			void finish() noexcept
+			{
+				stream_open = false;
+				lexer.extend(stream_buffer, false);
+			}
+
+			void resetStats() noexcept
+			{
+				JASOON_STAT(parse_stats = Parse_stats());
+			}
+
+			Token next()
+			{
+				const auto token = lexer.getToken();
+				JASOON_STAT(countToken(token));
+				return token;
+			}
+
+#ifdef JASOON_ENABLE_STATS
+			void countToken(Token token) noexcept
+			{
+				if (token == Token::Error)
+					return;
+				++parse_stats.tokens[static_cast<size_t>(token)];
+				switch (token)
+				{
+				case Token::String:
+					parse_stats.string_bytes += lexer.template getValue<string_t>().size();
+					break;
+				case Token::Interger:
+					++parse_stats.nodes[static_cast<size_t>(Json_type::Interger)];
+					break;
+				case Token::Float:
+					++parse_stats.nodes[static_cast<size_t>(Json_type::Float)];
+					break;
+				case Token::True:
+				case Token::False:
+					++parse_stats.nodes[static_cast<size_t>(Json_type::Boolean)];
+					break;
+				case Token::Null:
+					++parse_stats.nodes[static_cast<size_t>(Json_type::Null)];
+					break;
+				default:
+					break;
+				}
+			}
+
+			void countNode(Json_type t) noexcept
+			{
+				++parse_stats.nodes[static_cast<size_t>(t)];
+				if (!pool)
+					++parse_stats.node_allocations;
+			}
+#endif
+
+			//every failure lands in parse_error and returns false, nothing is printed or thrown
+			bool fail(Parse_errc code) noexcept //no position, e.g. the file cannot be opened
+			{
+				parse_error = { code };
+				return false;
+			}
+
+			bool fail(Parse_errc code, size_t offset) noexcept
+			{
+				parse_error = Parse_error::at(text, code, offset);
+				return false;
+			}
+
+			bool fail(Token token, Parse_errc expected) noexcept //token does not fit the grammar here
+			{
+				if (token == Token::Error)
+					return fail(lexer.error(), lexer.errorOffset());
+				return fail(expected, lexer.tokenOffset());
+			}
+
+			Parse_error outcome(bool ok) const noexcept
+			{
+				return ok ? Parse_error() : parse_error;
+			}
+
+			bool parseRoot(std::string_view s, Basic_json& root)
+			{
+				JASOON_STAT(parse_stats.bytes += s.size());
+				JASOON_STAT(Phase_timer timer(parse_stats.parse_time));
+				return parseValue(s, false, root);
+			}
+
+			bool fill(std::string_view s, Document& doc)
+			{
+				doc.clear();
+				Pool_guard guard{ *this, doc };
+				JASOON_STAT(const auto allocated = doc.allocated);
+				const auto ok = parseRoot(s, doc.root_value);
+				JASOON_STAT(parse_stats.node_allocations += doc.allocated - allocated);
+				return ok;
+			}
+
+			bool input(const string_t& s, InputMode mode, std::string_view& out)
+			{
+				if (mode == InputMode::String)
+				{
+					out = std::string_view(s.data(), s.size());
+					return true;
+				}
+				JASOON_STAT(Phase_timer timer(parse_stats.read_time));
+				std::ifstream f(s, std::ios::binary | std::ios::ate); //mode == InputMode::File
+				if (!f)
+					return fail(Parse_errc::Cannot_open_file);
+				const auto size = static_cast<size_t>(f.tellg());
+				if (size > parse_limits.max_document_size) //before reading any of it
+					return fail(Parse_errc::Document_too_large);
+				file_buffer.resize(size);
+				f.seekg(0);
+				f.read(file_buffer.data(), file_buffer.size());
+				out = file_buffer;
+				return true;
+			}
+
+			Basic_json makeString()
+			{
+				const auto& s = lexer.template getValue<string_t>();
+				JASOON_STAT(countNode(Json_type::String));
+				if (!pool)
+					return Basic_json(s);
+				Basic_json node;
+				node.type = Json_type::String;
+				node.value = pool->acquireString(s.size());
+				*std::get<string_ptr>(node.value) = s;
+				return node;
+			}
+
+			Basic_json makeObject(key_t* first_name, Basic_json* first, size_t n)
+			{
+				Basic_json node;
+				node.type = Json_type::Object;
+				JASOON_STAT(countNode(Json_type::Object));
+				if (pool)
+					node.value = pool->acquireObject(n);
+				else
+				{
+					node.value = std::make_unique<object_t>();
+					std::get<object_ptr>(node.value)->reserve(n);
+				}
+				auto& members = *std::get<object_ptr>(node.value);
+				for (size_t i = 0; i < n; ++i)
+					addMember(members, std::move(first_name[i]), std::move(first[i]));
+				return node;
+			}
+
+			Basic_json makeArray(Basic_json* first, size_t n)
+			{
+				if (const auto kind = packedKind(first, n); kind != Json_type::Null)
+					return kind == Json_type::Interger
+						? makePacked<interger_t>(first, n) : makePacked<float_t>(first, n);
+				Basic_json node;
+				node.type = Json_type::Array;
+				JASOON_STAT(countNode(Json_type::Array));
+				if (pool)
+					node.value = pool->acquireArray(n);
+				else
+				{
+					node.value = std::make_unique<array_t>();
+					std::get<array_ptr>(node.value)->reserve(n);
+				}
+				auto& elements = *std::get<array_ptr>(node.value);
+				for (auto it = first; it != first + n; ++it)
+					elements.push_back(std::move(*it));
+				return node;
+			}
+
+			template<typename T>
+			Basic_json makePacked(const Basic_json* first, size_t n) //every element holds a T
+			{
+				Basic_json node;
+				node.type = Json_type::Array;
+				JASOON_STAT(countNode(Json_type::Array));
+				if (pool)
+					node.value = pool->template acquirePacked<T>(n);
+				else
+				{
+					node.value = std::make_unique<Packed<T>>();
+					std::get<packed_ptr<T>>(node.value)->reserve(n);
+				}
+				auto& numbers = *std::get<packed_ptr<T>>(node.value);
+				for (auto it = first; it != first + n; ++it)
+					numbers.push_back(std::get<T>(it->value));
+				return node;
+			}
+
+			void addMember(object_t& members, key_t&& name, Basic_json&& element)
+			{
+				auto member = pool ? pool->acquireMember() : typename Document::member_node();
+				if (member.empty())
+				{
+					JASOON_STAT(++parse_stats.node_allocations);
+					members.emplace(std::move(name), std::move(element));
+					return;
+				}
+				member.key() = std::move(name);
+				member.mapped() = std::move(element);
+				auto result = members.insert(std::move(member));
+				if (!result.inserted) //duplicate name, the first one wins
+					pool->releaseMember(std::move(result.node));
+			}
+
+			bool open(bool is_object)
+			{
+				if (outer_depth + frames.size() >= parse_limits.max_depth)
+					return fail(Parse_errc::Nesting_too_deep, lexer.tokenOffset());
+				auto node = Schema::none;
+				if (schema)
+				{
+					node = schemaNode();
+					if (!schema->allows(node, is_object ? Schema::Object_bit : Schema::Array_bit))
+						return failSchema(Schema_errc::Type); //before parsing what it holds
+				}
+				frames.push_back({ is_object, values.size(), name_count, node, selected });
+				if (projection && !is_object)
+					selected = projection->items(selected);
+				JASOON_STAT(parse_stats.max_depth = std::max(parse_stats.max_depth, frames.size()));
+				return true;
+			}
+
+			size_t schemaNode() const //of the value at the current position
+			{
+				if (frames.empty())
+					return 0;
+				const auto& frame = frames.back();
+				return frame.is_object
+					? schema->property(frame.schema_node, names[name_count - 1])
+					: schema->items(frame.schema_node);
+			}
+
+			bool failSchema(Schema_errc code)
+			{
+				schema_failure = { code, schemaPath() };
+				return fail(Parse_errc::Schema_mismatch, lexer.tokenOffset());
+			}
+
+			std::string schemaPath() const //json pointer of the value at the current position
+			{
+				std::string path;
+				for (size_t i = 0; i < frames.size(); ++i)
+				{
+					const auto& frame = frames[i];
+					const auto last = i + 1 == frames.size();
+					path += '/';
+					if (frame.is_object)
+						Schema::escapePointer(path, names[(last ? name_count : frames[i + 1].first_name) - 1]);
+					else
+						path += std::to_string((last ? values.size() : frames[i + 1].first_value) - frame.first_value);
+				}
+				return path;
+			}
+
+			Basic_json close() //builds the innermost open container from the stack tops
+			{
+				const auto frame = frames.back();
+				frames.pop_back();
+				const auto n = values.size() - frame.first_value;
+				auto node = frame.is_object
+					? makeObject(names.data() + frame.first_name, values.data() + frame.first_value, n)
+					: makeArray(values.data() + frame.first_value, n);
+				values.erase(values.begin() + frame.first_value, values.end());
+				name_count = frame.first_name;
+				return node;
+			}
+
+			//iterative, so the nesting depth costs heap rather than stack. a trailing ',' before
+			//'}' or ']' is accepted, that is how stringify() writes containers
+			bool parseValue(std::string_view s, bool any_value, Basic_json& element)
+			{
+				text = s;
+				if (s.size() > parse_limits.max_document_size)
+					return fail(Parse_errc::Document_too_large);
+				start(s, any_value, false);
+				return run(element, std::numeric_limits<size_t>::max()) == Step::Done;
+			}
+
+			void start(std::string_view s, bool any_value, bool more_input)
+			{
+				lexer.setInput(s, parse_limits.max_string_length, more_input);
+				frames.clear();
+				values.clear();
+				name_count = 0;
+				state = any_value ? State::Value : State::Root;
+				selected = projection ? 0 : Projection::all;
+			}
+
+			//one token per round, every bit of progress kept in the members, so it can stop after
+			//about budget bytes or at the end of a partial input and carry on from there later
+			Step run(Basic_json& root, size_t budget)
+			{
+				const auto stop = lexer.offset() + std::min(std::max<size_t>(budget, 1),
+					std::numeric_limits<size_t>::max() - lexer.offset());
+				Basic_json element;
+				for (;;)
+				{
+					if (state == State::After_root)
+					{
+						lexer.skipSpace();
+						if (!lexer.atEnd())
+							return failed(Parse_errc::Trailing_characters, lexer.offset());
+						return lexer.partialInput() ? Step::Need_input : Step::Done;
+					}
+					if (lexer.offset() >= stop)
+						return Step::Yield;
+					if (selected != Projection::all && (state == State::Value || state == State::Value_or_end))
+					{
+						//a value outside the projection, or a scalar where only its members are kept
+						const auto c = lexer.peek();
+						if (c != '}' && c != ']' && (selected == Projection::none || (c != '{' && c != '[')))
+						{
+							if (const auto token = lexer.skipValue(); token == Token::Error)
+							{
+								if (!lexer.starved())
+									return failed(token, Parse_errc::Value_expected);
+								lexer.rewind();
+								return Step::Need_input;
+							}
+							if (state == State::Value && selected != Projection::none && !frames.empty())
+								--name_count; //kept in case the value held selected members
+							state = State::After_value;
+							continue;
+						}
+					}
+					const auto token = next();
+					if (token == Token::Error && lexer.starved())
+					{
+						lexer.rewind();
+						return Step::Need_input;
+					}
+					switch (state)
+					{
+					case State::Root:
+						if (token != Token::Object_begin && token != Token::Array_begin)
+							return failed(token, Parse_errc::Root_expected);
+						[[fallthrough]];
+					case State::Value:
+					case State::Value_or_end:
+						if (state == State::Value_or_end && token == Token::Array_end)
+						{
+							element = close();
+							break;
+						}
+						switch (token) //token starts a value
+						{
+						case Token::Object_begin:
+							if (!open(true))
+								return Step::Failed;
+							state = State::Name_or_end;
+							continue;
+						case Token::Array_begin:
+							if (!open(false))
+								return Step::Failed;
+							state = State::Value_or_end;
+							continue;
+						case Token::String:
+							element = makeString();
+							break;
+						case Token::Interger:
+							element = lexer.template getValue<interger_t>();
+							break;
+						case Token::Float:
+							element = lexer.template getValue<float_t>();
+							break;
+						case Token::True:
+							element = true;
+							break;
+						case Token::False:
+							element = false;
+							break;
+						case Token::Null:
+							element = nullptr;
+							break;
+						default:
+							return failed(token, Parse_errc::Value_expected);
+						}
+						break;
+					case State::Name_or_end:
+						if (token == Token::Object_end)
+						{
+							element = close();
+							break;
+						}
+						if (token != Token::String)
+							return failed(token, Parse_errc::Name_expected);
+						if (projection)
+						{
+							selected = projection->member(frames.back().selection, lexer.template getValue<string_t>());
+							if (selected == Projection::none) //its value is skipped, the name is not kept
+							{
+								state = State::Name_separator;
+								continue;
+							}
+						}
+						if (name_count == names.size())
+							names.emplace_back();
+						names[name_count++] = key_table.intern(lexer.template getValue<string_t>());
+						state = State::Name_separator;
+						continue;
+					case State::Name_separator:
+						if (token != Token::Name_separator)
+							return failed(token, Parse_errc::Name_separator_expected);
+						state = State::Value;
+						continue;
+					case State::After_value:
+					{
+						const auto is_object = frames.back().is_object;
+						if (token == Token::Value_separator)
+						{
+							state = is_object ? State::Name_or_end : State::Value_or_end;
+							if (projection && !is_object)
+								selected = projection->items(frames.back().selection);
+							continue;
+						}
+						if (token != (is_object ? Token::Object_end : Token::Array_end))
+							return failed(token, is_object
+								? Parse_errc::Object_end_expected : Parse_errc::Array_end_expected);
+						element = close();
+						break;
+					}
+					case State::After_root:
+						break;
+					}
+					//element is complete: add it to its container
+					if (schema)
+					{
+						if (const auto code = schema->check(schemaNode(), element); code != Schema_errc::None)
+						{
+							failSchema(code);
+							return Step::Failed;
+						}
+					}
+					if (frames.empty())
+					{
+						root = std::move(element);
+						state = State::After_root;
+						continue;
+					}
+					if (values.size() - frames.back().first_value == parse_limits.max_elements)
+						return failed(Parse_errc::Too_many_elements, lexer.tokenOffset());
+					values.push_back(std::move(element));
+					state = State::After_value;
+				}
+			}
+
+			template<typename... Args>
+			Step failed(Args... args) noexcept
+			{
+				fail(args...);
+				return Step::Failed;
+			}
+
+			Lexer lexer;
+			Parse_stats parse_stats;
+			Parse_limits parse_limits;
+			size_t outer_depth = 0; //containers around the text, see parseElement()
+			Parse_error parse_error; //of the last failed parse
+			std::string_view text; //input of the current parse, to locate errors
+			Document* pool = nullptr; //node source of the current parse, if any
+			const Schema* schema = nullptr; //checked during the current parse, if any
+			const Projection* projection = nullptr; //kept by the current parse, if any
+			size_t selected = Projection::all; //projection node of the next value
+			Schema_error schema_failure;
+			//explicit parse stacks, kept with their capacity across parses
+			std::vector<Frame> frames;
+			std::vector<Basic_json> values;
+			std::vector<key_t> names;
+			size_t name_count = 0;
+			State state = State::Root;
+			std::string stream_buffer; //input of parse_async so far
+			bool stream_open = false;  //parse_async expects more of it
+			Key_table key_table; //names seen by this parser, shared by all of its documents
+			std::string file_buffer; //reused by InputMode::File
+		};
+
+		class Parse_task //coroutine of Parser::parse_async, owns its frame
+		{
+		public:
+			struct promise_type
+			{
+				promise_type(Parser& p, size_t) noexcept : parser(&p) {}
+
+				Parse_task get_return_object() noexcept
+				{
+					return Parse_task(std::coroutine_handle<promise_type>::from_promise(*this));
+				}
+
+				std::suspend_never initial_suspend() noexcept //runs until it first needs input
+				{
+					return {};
+				}
+
+				std::suspend_always final_suspend() noexcept
+				{
+					return {};
+				}
+
+				void return_value(Basic_json&& root) noexcept
+				{
+					result = std::move(root);
+				}
+
+				void unhandled_exception() noexcept
+				{
+					error = std::current_exception();
+				}
+
+				Parser* parser;
+				Basic_json result;
+				std::exception_ptr error;
+				bool needs_input = false;
+			};
+
+			Parse_task(Parse_task&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+
+			Parse_task& operator=(Parse_task&& other) noexcept
+			{
+				if (this != &other)
+				{
+					if (handle)
+						handle.destroy();
+					handle = std::exchange(other.handle, nullptr);
+				}
+				return *this;
+			}
+
+			~Parse_task()
+			{
+				if (handle)
+					handle.destroy();
+			}
+
+			void feed(std::string_view chunk) //appends input, parsed by the following resume()s
+			{
+				handle.promise().parser->feed(chunk);
+			}
+
+			void finish() noexcept //no more input: what is left must complete the document
+			{
+				handle.promise().parser->finish();
+			}
+
+			bool resume() //runs until the budget is spent or the input runs out, false once done
+			{
+				if (!handle.done())
+					handle.resume();
+				return !handle.done();
+			}
+
+			bool done() const noexcept
+			{
+				return handle.done();
+			}
+
+			bool wants_input() const noexcept //resuming is pointless before the next feed() or finish()
+			{
+				return !handle.done() && handle.promise().needs_input;
+			}
+
+			Basic_json get() //the document once done, throws input_error if it is malformed
+			{
+				if (!handle.done())
+					throw std::logic_error("parse_async: document not complete");
+				if (handle.promise().error)
+					std::rethrow_exception(handle.promise().error);
+				return std::move(handle.promise().result);
+			}
+
+		private:
+			friend class Parser;
+
+			struct Suspend
+			{
+				bool await_ready() const noexcept
+				{
+					return false;
+				}
+
+				void await_suspend(std::coroutine_handle<promise_type> h) const noexcept
+				{
+					h.promise().needs_input = for_input;
+				}
+
+				void await_resume() const noexcept {}
+
+				bool for_input;
+			};
+
+			explicit Parse_task(std::coroutine_handle<promise_type> h) noexcept : handle(h) {}
+
+			std::coroutine_handle<promise_type> handle;
+		};
+
+
+	public:
+		template<typename T>
+		reference operator[](T index) noexcept
+		{
+			if constexpr(std::is_integral_v<T>)
+			{
+				return elements()[index];
+			}
+			else if constexpr(std::is_constructible_v<string_t, T>) //T can be char* , std::string ...
+			{
+				return member(*std::get<object_ptr>(value), index);
+			}
+		}
+
+		template<typename T>
+		const_reference operator[](T index) const //a packed array builds its elements once, see Packed
+		{
+			if constexpr(std::is_integral_v<T>)
+			{
+				return elementAt(static_cast<size_type>(index));
+			}
+			else if constexpr(std::is_constructible_v<string_t, T>)
+			{
+				return member(std::as_const(*std::get<object_ptr>(value)), index);
+			}
+		}
+
+		reference operator[](const key_t& key) noexcept //hashed once, interned keys compare by pointer
+		{
+			return std::get<object_ptr>(value)->operator[](key);
+		}
+
+		const_reference operator[](const key_t& key) const noexcept
+		{
+			return member(std::as_const(*std::get<object_ptr>(value)), key);
+		}
+
+		template<typename T>
+		reference at(T index) //provide check with type and index
+		{
+			if constexpr(std::is_integral_v<T>)
+			{
+				if (is_array())
+					return elements().at(index);
+				else
+					throw type_error("only array is valid");
+			}
+			else if constexpr(std::is_constructible_v<string_t, T>) //T can be char* , std::string ...
+			{
+				if (is_object())
+					return memberAt(*std::get<object_ptr>(value), index);
+				else
+					throw type_error("only object is valid");
+			}
+		}
+
+		template<typename T>
+		const_reference at(T index) const
+		{
+			if constexpr(std::is_integral_v<T>)
+			{
+				if (!is_array())
+					throw type_error("only array is valid");
+				if (index < 0 || static_cast<size_type>(index) >= size())
+					throw std::out_of_range("array index out of range");
+				return elementAt(static_cast<size_type>(index));
+			}
+			else if constexpr(std::is_constructible_v<string_t, T>)
+			{
+				if (is_object())
+					return memberAt(std::as_const(*std::get<object_ptr>(value)), index);
+				else
+					throw type_error("only object is valid");
+			}
+		}
+
+		reference at(const key_t& key)
+		{
+			if (is_object())
+				return std::get<object_ptr>(value)->at(key);
+			else
+				throw type_error("only object is valid");
+		}
+
+		const_reference at(const key_t& key) const
+		{
+			if (is_object())
+				return std::get<object_ptr>(value)->at(key);
+			else
+				throw type_error("only object is valid");
+		}
+
+	private:
+		//looked up by the chars, a Key is only made when the member is inserted
+		static reference member(object_t& members, std::string_view name)
+		{
+			const auto it = members.find(name);
+			if (it != members.end())
+				return it->second;
+			return members.emplace(key_t(name), Basic_json()).first->second;
+		}
+
+		static const_reference member(const object_t& members, std::string_view name) noexcept //null if missing
+		{
+			return found(members, members.find(name));
+		}
+
+		static const_reference member(const object_t& members, const key_t& name) noexcept
+		{
+			return found(members, members.find(name));
+		}
+
+		static const_reference found(const object_t& members, typename object_t::const_iterator it) noexcept
+		{
+			static const Basic_json missing; //a const read never inserts
+			return it != members.end() ? it->second : missing;
+		}
+
+		static reference memberAt(object_t& members, std::string_view name)
+		{
+			const auto it = members.find(name);
+			if (it == members.end())
+				throw std::out_of_range("no such member");
+			return it->second;
+		}
+
+		static const_reference memberAt(const object_t& members, std::string_view name)
+		{
+			const auto it = members.find(name);
+			if (it == members.end())
+				throw std::out_of_range("no such member");
+			return it->second;
+		}
+
+		Json_type type;
+
+		Json_value value;
+
+	public:
+		constexpr Basic_json() noexcept : type(Json_type::Null) {}
+
+		template<typename U>
+		constexpr Basic_json(U val)
+			noexcept(std::is_nothrow_constructible_v<interger_t, U>
+				&& std::is_nothrow_constructible_v<float_t, U>)
+		{
+			if constexpr(std::is_integral_v<U>)
+			{
+				type = Json_type::Interger;
+				value = interger_t(val);
+			}
+			else if constexpr(std::is_floating_point_v<U>)
+			{
+				type = Json_type::Float;
+				value = float_t(val);
+			}
+		}
+
+		constexpr Basic_json(interger_t i)
+			noexcept(std::is_nothrow_constructible_v<interger_t, interger_t>)
+			: type(Json_type::Interger), value(i) {}
+
+		constexpr Basic_json(float_t f)
+			noexcept(std::is_nothrow_constructible_v<float_t, float_t>)
+			: type(Json_type::Float), value(f) {}
+
+		constexpr Basic_json(boolean_t b)
+			noexcept(std::is_nothrow_constructible_v<boolean_t, boolean_t>)
+			: type(Json_type::Boolean), value(b) {}
+
+		constexpr Basic_json(std::nullptr_t) noexcept : type(Json_type::Null) {}
+
+		Basic_json(std::initializer_list<Basic_json> list)
+		{
+			const auto is_object = std::all_of(list.begin(), list.end(), [](const auto& element)
+			{
+				return element.is_array() && element.size() == 2 && element[0].is_string();
+			});
+
+			if (is_object)
+			{
+				type = Json_type::Object;
+				value = std::make_unique<object_t>();
+				for (const auto& element : list)
+					std::get<object_ptr>(value)
+					->emplace(*std::get<string_ptr>(element[0].value), element[1]);
+			}
+			else
+			{
+				type = Json_type::Array;
+				value = std::make_unique<array_t>(list.begin(), list.end());
+			}
+		}
+
+		Basic_json(const object_t& o) :type(Json_type::Object), value(std::make_unique<object_t>(o)) {}
+
+		Basic_json(const array_t& a) :type(Json_type::Array), value(std::make_unique<array_t>(a)) {}
+
+		Basic_json(const string_t& s) :type(Json_type::String), value(std::make_unique<string_t>(s)) {}
+
+		Basic_json(const char* s) :type(Json_type::String), value(std::make_unique<string_t>(s)) {}
+
+		Basic_json(std::string_view sv) :type(Json_type::String), value(std::make_unique<string_t>(sv)) {}
+
+		Basic_json(Json_view view) :type(view.get_type()) //copies a snapshot or "..."_json document
+		{
+			switch (type)
+			{
+			case Json_type::Object:
+			{
+				auto members = std::make_unique<object_t>();
+				members->reserve(view.size());
+				for (size_t i = 0; i < view.size(); ++i)
+					members->emplace(key_t(view.key(i)), Basic_json(view.value(i)));
+				value = std::move(members);
+				break;
+			}
+			case Json_type::Array:
+			{
+				auto elements = std::make_unique<array_t>();
+				elements->reserve(view.size());
+				for (size_t i = 0; i < view.size(); ++i)
+					elements->push_back(Basic_json(view[i]));
+				value = std::move(elements);
+				pack();
+				break;
+			}
+			case Json_type::String:
+				value = std::make_unique<string_t>(static_cast<std::string_view>(view));
+				break;
+			case Json_type::Interger:
+				value = static_cast<interger_t>(view);
+				break;
+			case Json_type::Float:
+				value = static_cast<float_t>(view);
+				break;
+			case Json_type::Boolean:
+				value = static_cast<boolean_t>(view);
+				break;
+			default:
+				break;
+			}
+		}
+
+		Basic_json(Json_type t) :type(t)
+		{
+			switch (type)
+			{
+			case Json_type::Object:
+				value = std::make_unique<object_t>();
+				break;
+			case Json_type::Array:
+				value = std::make_unique<array_t>();
+				break;
+			case Json_type::String:
+				value = std::make_unique<string_t>();
+				break;
+			case Json_type::Interger:
+				value = static_cast<interger_t>(0);
+				break;
+			case Json_type::Float:
+				value = static_cast<float_t>(0);
+				break;
+			case Json_type::Boolean:
+				value = false;
+				break;
+			case Json_type::Null:
+				break;
+			default:
+				break;
+			}
+		}
+
+		Basic_json(const Basic_json& other)
+		{
+			*this = other;
+		}
+
+		reference operator=(const Basic_json& other)
+		{
+			if (this != &other)
+			{
+				type = other.type;
+				switch (type)
+				{
+				case Json_type::Object:
+					value = std::make_unique<object_t>(*std::get<object_ptr>(other.value));
+					break;
+				case Json_type::Array:
+					if (auto ints = std::get_if<packed_ptr<interger_t>>(&other.value))
+						value = std::make_unique<Packed<interger_t>>(**ints);
+					else if (auto floats = std::get_if<packed_ptr<float_t>>(&other.value))
+						value = std::make_unique<Packed<float_t>>(**floats);
+					else
+						value = std::make_unique<array_t>(*std::get<array_ptr>(other.value));
+					break;
+				case Json_type::String:
+					value = std::make_unique<string_t>(*std::get<string_ptr>(other.value));
+					break;
+				case Json_type::Interger:
+					value = std::get<interger_t>(other.value);
+					break;
+				case Json_type::Float:
+					value = std::get<float_t>(other.value);
+					break;
+				case Json_type::Boolean:
+					value = std::get<boolean_t>(other.value);
+					break;
+				case Json_type::Null:
+					break;
+				default:
+					break;
+				}
+			}
+			return *this;
+		}
+
+		Basic_json(Basic_json&& other) noexcept
+			:type(other.type), value(std::move(other.value))
+		{
+
+		}
+
+		reference operator=(Basic_json&& other) noexcept
+		{
+			if (this != &other)
+			{
+				type = other.type;
+				value = std::move(other.value);
+			}
+			return *this;
+		}
+
+		~Basic_json() = default;
+
+		bool operator==(const Basic_json& other) const noexcept
+		{
+			if (type != other.type)
+				return false;
+			switch (type) //compare the pointees, not the owning pointers
+			{
+			case Json_type::Object:
+				return *std::get<object_ptr>(value) == *std::get<object_ptr>(other.value);
+			case Json_type::Array:
+				return arrayEquals(other);
+			case Json_type::String:
+				return *std::get<string_ptr>(value) == *std::get<string_ptr>(other.value);
+			case Json_type::Null:
+				return true;
+			default:
+				return value == other.value;
+			}
+		}
+
+		bool operator!=(const Basic_json& other) const noexcept
+		{
+			return !(*this == other);
+		}
+	private:
+		bool arrayEquals(const Basic_json& other) const noexcept
+		{
+			if (value.index() == other.value.index()) //same storage
+			{
+				if (auto ints = std::get_if<packed_ptr<interger_t>>(&value))
+					return **ints == *std::get<packed_ptr<interger_t>>(other.value);
+				if (auto floats = std::get_if<packed_ptr<float_t>>(&value))
+					return **floats == *std::get<packed_ptr<float_t>>(other.value);
+				return *std::get<array_ptr>(value) == *std::get<array_ptr>(other.value);
+			}
+			if (size() != other.size())
+				return false;
+			for (size_type i = 0; i < size(); ++i)
+			{
+				const auto equal = withElement(i, [&](const Basic_json& a)
+				{
+					return other.withElement(i, [&](const Basic_json& b)
+					{
+						return a == b;
+					});
+				});
+				if (!equal)
+					return false;
+			}
+			return true;
+		}
+
+	public:
+		string_t stringify() const
+		{
+			string_t s;
+			if (type == Json_type::Object)
+				stringifyObject(s, 1);
+			else if (type == Json_type::Array)
+				stringifyArray(s, 1);
+			return s;
+		}
+
+		string_t stringify(Stringify_stats& stats) const //zero stats unless JASOON_ENABLE_STATS
+		{
+			stats = Stringify_stats();
+			string_t s;
+			{
+				JASOON_STAT(Stats_scope scope(stats));
+				JASOON_STAT(countStringify(1));
+				s = stringify();
+			}
+			JASOON_STAT(stats.bytes = s.size());
+			return s;
+		}
+
+		//same bytes as stringify(), ranges of children are serialized concurrently (inside the
+		//big child containers when the top level has few) and copied once into a string sized up front
+		string_t stringify_parallel(Thread_pool& pool = Thread_pool::shared()) const
+		{
+			std::vector<string_t> pieces;
+			stringifyPieces(pieces, pool);
+			size_t total = 0;
+			for (const auto& piece : pieces)
+				total += piece.size();
+			string_t s;
+			s.reserve(total);
+			for (const auto& piece : pieces)
+				s += piece;
+			return s;
+		}
+
+		//gather form: sink(const string_t&) receives the pieces in output order, e.g. for writev
+		template<typename Sink>
+		void stringify_parallel_to(Sink&& sink, Thread_pool& pool = Thread_pool::shared()) const
+		{
+			std::vector<string_t> pieces;
+			stringifyPieces(pieces, pool);
+			for (const auto& piece : pieces)
+				sink(piece);
+		}
+	private:
+		void addSpace(string_t& s, int num) const
+		{
+			for (int i = 0; i < num; ++i)
+				s += "  ";
+		}
+#ifdef JASOON_ENABLE_STATS
+		static Stringify_stats*& activeStats() noexcept //target of the stringify(stats) running on this thread
+		{
+			thread_local Stringify_stats* active = nullptr;
+			return active;
+		}
+
+		struct Stats_scope
+		{
+			explicit Stats_scope(Stringify_stats& stats) noexcept : timer(stats.stringify_time)
+			{
+				activeStats() = &stats;
+			}
+			~Stats_scope()
+			{
+				activeStats() = nullptr;
+			}
+			Phase_timer timer;
+		};
+
+		void countStringify(int depth) const noexcept
+		{
+			if (auto stats = activeStats())
+			{
+				++stats->nodes[static_cast<size_t>(type)];
+				stats->max_depth = std::max(stats->max_depth, static_cast<size_t>(depth));
+				if (type == Json_type::String)
+					stats->string_bytes += std::get<string_ptr>(value)->size();
+			}
+		}
+#endif
+		void stringifyValue(string_t& s, int depth) const
+		{
+			JASOON_STAT(countStringify(depth));
+			switch (type)
+			{
+			case Json_type::Object:
+				stringifyObject(s, depth);
+				break;
+			case Json_type::Array:
+				stringifyArray(s, depth);
+				break;
+			case Json_type::String:
+			{
+				s += "\"";
+				s += *std::get<string_ptr>(value);
+				s += "\"";
+				break;
+			}
+			case Json_type::Interger:
+				s += std::to_string(std::get<interger_t>(value));
+				break;
+			case Json_type::Float:
+				s += std::to_string(std::get<float_t>(value));
+				break;
+			case Json_type::Boolean:
+			{
+				if (std::get<boolean_t>(value) == true)
+					s += "true";
+				else
+					s += "false";
+				break;
+			}
+			case Json_type::Null:
+				s += "null";
+				break;
+			default:
+				break;
+			}
+		}
+		void stringifyMember(string_t& s, const typename object_t::value_type& element, int depth) const
+		{
+			JASOON_STAT(if (auto stats = activeStats()) stats->string_bytes += element.first.size());
+			s += '"';
+			s += element.first;
+			s += "\": ";
+			element.second.stringifyValue(s, depth + 1);
+			s += ",\n";
+			addSpace(s, depth);
+		}
+		void stringifyElement(string_t& s, const Basic_json& element, int depth) const
+		{
+			element.stringifyValue(s, depth + 1);
+			s += ",\n";
+			addSpace(s, depth);
+		}
+		void stringifyObject(string_t& s, int depth) const
+		{
+			s += "{\n";
+			addSpace(s, depth);
+			for (const auto& element : *std::get<object_ptr>(value))
+				stringifyMember(s, element, depth);
+			s += '}';
+		}
+		void stringifyArray(string_t& s, int depth) const
+		{
+			s += "[\n";
+			addSpace(s, depth);
+			forEachElement([&](const Basic_json& element)
+			{
+				stringifyElement(s, element, depth);
+			});
+			s += ']';
+		}
+		//stringify_parallel's work list: pieces[i] is fixed text when tasks[i] has no container,
+		//else the children [first, last) of that container, written by a pool thread
+		struct Stringify_task
+		{
+			const Basic_json* container = nullptr;
+			const typename object_t::value_type* const* members = nullptr; //of an object, by index
+			size_t first = 0;
+			size_t last = 0;
+			int depth = 0;
+		};
+
+		struct Stringify_plan
+		{
+			std::vector<string_t>& pieces;
+			std::vector<Stringify_task> tasks;
+			std::deque<std::vector<const typename object_t::value_type*>> members; //stable while planning
+
+			string_t& text()
+			{
+				tasks.emplace_back();
+				return pieces.emplace_back();
+			}
+
+			void range(const Stringify_task& task)
+			{
+				tasks.push_back(task);
+				pieces.emplace_back();
+			}
+		};
+
+		void stringifyPieces(std::vector<string_t>& pieces, Thread_pool& pool) const
+		{
+			if (type != Json_type::Object && type != Json_type::Array)
+			{
+				pieces.push_back(stringify());
+				return;
+			}
+			Stringify_plan plan{ pieces, {}, {} };
+			planPieces(plan, 1, pool.size() * 4, 8);
+			pool.parallel_for(plan.tasks.size(), [&](size_t i)
+			{
+				if (const auto& task = plan.tasks[i]; task.container)
+					task.container->stringifyRange(pieces[i], task);
+			});
+		}
+
+		//splits the children into parts ranges. with fewer children than parts, each child is a
+		//range of its own and the big containers among them are split in turn, so a document
+		//like {"results": [...]} still spreads over the pool; levels bounds the descent
+		void planPieces(Stringify_plan& plan, int depth, size_t parts, int levels) const
+		{
+			auto& members = plan.members.emplace_back();
+			if (type == Json_type::Object)
+				for (const auto& element : *std::get<object_ptr>(value))
+					members.push_back(&element);
+			const auto n = type == Json_type::Object ? members.size() : size();
+			const auto child = [&](size_t i) -> const Basic_json* //null for packed numbers
+			{
+				if (type == Json_type::Object)
+					return &members[i]->second;
+				const auto array = std::get_if<array_ptr>(&value);
+				return array ? &(**array)[i] : nullptr;
+			};
+			const auto weight = [](const Basic_json* element) -> size_t
+			{
+				return element && (element->is_object() || element->is_array()) ? std::max<size_t>(element->size(), 1) : 1;
+			};
+			auto& open = plan.text();
+			open = type == Json_type::Object ? "{\n" : "[\n";
+			addSpace(open, depth);
+			const auto task = [&](size_t first, size_t last)
+			{
+				return Stringify_task{ this, members.data(), first, last, depth };
+			};
+			if (n >= parts || levels == 0)
+			{
+				const auto chunk_count = std::min(n, parts);
+				for (size_t chunk = 0; chunk < chunk_count; ++chunk)
+					plan.range(task(n * chunk / chunk_count, n * (chunk + 1) / chunk_count));
 			}
-			Basic_json parseArray()
+			else
 			{
-				Basic_json array(Json_type::Array); //empty json array
-				auto token = lexer.getToken();
-				while (token != Token::Array_end)
+				size_t total = 0;
+				for (size_t i = 0; i < n; ++i)
+					total += weight(child(i));
+				for (size_t i = 0; i < n; ++i)
 				{
-					switch (token)
-					{
-					case Token::Object_begin:
-						array.push_back(parseObject());
-						break;
-					case Token::Array_begin:
-						array.push_back(parseArray());
-						break;
-					case Token::Value_separator:
-						break;
-					case Token::String:
-						array.push_back(lexer.template getValue<string_t>());
-						break;
-					case Token::Interger:
-						array.push_back(lexer.template getValue<interger_t>());
-						break;
-					case Token::Float:
-						array.push_back(lexer.template getValue<float_t>());
-						break;
-					case Token::True:
-						array.push_back(true);
-						break;
-					case Token::False:
-						array.push_back(false);
-						break;
-					case Token::Null:
-						array.push_back(nullptr);
-						break;
-					case Token::Name_separator:
+					const auto element = child(i);
+					const auto share = parts * weight(element) / total;
+					if (!element || share < 2 || !(element->is_object() || element->is_array()))
 					{
-						std::cerr << "'line " << lexer.getLineNo() << "': unexpected ':'";
-						throw input_error("invalid input");
+						plan.range(task(i, i + 1));
+						continue;
 					}
-					case Token::Object_end:
-					default:
+					auto& name = plan.text(); //what stringifyMember() writes around the value
+					if (type == Json_type::Object)
 					{
-						std::cerr << "'line " << lexer.getLineNo() << "': ']' is expected";
-						throw input_error("invalid input");
+						name += '"';
+						name += members[i]->first;
+						name += "\": ";
 					}
-					}
-					token = lexer.getToken();
+					element->planPieces(plan, depth + 1, share, levels - 1);
+					auto& separator = plan.text();
+					separator = ",\n";
+					addSpace(separator, depth);
 				}
-				return array;
 			}
-			Lexer lexer;
-		};
-
-		static Parser parser;
+			plan.text() = type == Json_type::Object ? "}" : "]";
+		}
 
-	public:
-		template<typename T>
-		reference operator[](T index) noexcept
+		void stringifyRange(string_t& s, const Stringify_task& task) const
 		{
-			if constexpr(std::is_integral_v<T>)
-			{
-				return std::get<array_ptr>(value)->operator[](index);
-			}
-			else if constexpr(std::is_constructible_v<string_t, T>) //T can be char* , std::string ...
+			for (auto i = task.first; i < task.last; ++i)
 			{
-				return std::get<object_ptr>(value)->operator[](index);
+				if (type == Json_type::Object)
+					stringifyMember(s, *task.members[i], task.depth);
+				else
+					withElement(i, [&](const Basic_json& element)
+					{
+						stringifyElement(s, element, task.depth);
+					});
 			}
 		}
+	public:
+		std::vector<std::uint8_t> to_cbor() const
+		{
+			std::vector<std::uint8_t> out;
+			writeCbor(out);
+			return out;
+		}
+
+		std::vector<std::uint8_t> to_msgpack() const
+		{
+			std::vector<std::uint8_t> out;
+			writeMsgpack(out);
+			return out;
+		}
+
+		static value_type from_cbor(const std::uint8_t* data, size_type size)
+		{
+			return from_cbor(data, size, Parse_limits());
+		}
+
+		static value_type from_cbor(const std::uint8_t* data, size_type size, const Parse_limits& limits)
+		{
+			return CborReader(data, size, limits).parse();
+		}
+
+		static value_type from_cbor(const std::vector<std::uint8_t>& v)
+		{
+			return from_cbor(v.data(), v.size());
+		}
+
+		static value_type from_cbor(const std::vector<std::uint8_t>& v, const Parse_limits& limits)
+		{
+			return from_cbor(v.data(), v.size(), limits);
+		}
+
+		static value_type from_msgpack(const std::uint8_t* data, size_type size)
+		{
+			return from_msgpack(data, size, Parse_limits());
+		}
+
+		static value_type from_msgpack(const std::uint8_t* data, size_type size, const Parse_limits& limits)
+		{
+			return MsgpackReader(data, size, limits).parse();
+		}
+
+		static value_type from_msgpack(const std::vector<std::uint8_t>& v)
+		{
+			return from_msgpack(v.data(), v.size());
+		}
+
+		static value_type from_msgpack(const std::vector<std::uint8_t>& v, const Parse_limits& limits)
+		{
+			return from_msgpack(v.data(), v.size(), limits);
+		}
+	private:
+		static void putBigEndian(std::vector<std::uint8_t>& out, std::uint64_t n, int bytes)
+		{
+			for (int shift = (bytes - 1) * 8; shift >= 0; shift -= 8)
+				out.push_back(static_cast<std::uint8_t>(n >> shift));
+		}
+
+		static bool fitsFloat(double d) noexcept //float32 is enough to hold d exactly
+		{
+			return d != d || static_cast<double>(static_cast<float>(d)) == d;
+		}
 
 		template<typename T>
-		const_reference operator[](T index) const noexcept
+		static std::uint64_t bitsOf(T f) noexcept
 		{
-			if constexpr(std::is_integral_v<T>)
+			if constexpr(sizeof(T) == 4)
 			{
-				return std::get<array_ptr>(value)->operator[](index);
+				std::uint32_t bits;
+				std::memcpy(&bits, &f, sizeof(bits));
+				return bits;
 			}
-			else if constexpr(std::is_constructible_v<string_t, T>)
+			else
 			{
-				return std::get<object_ptr>(value)->operator[](index);
+				std::uint64_t bits;
+				std::memcpy(&bits, &f, sizeof(bits));
+				return bits;
 			}
 		}
 
-		template<typename T>
-		reference at(T index) //provide check with type and index
+		static void cborHead(std::vector<std::uint8_t>& out, std::uint8_t major, std::uint64_t n)
 		{
-			if constexpr(std::is_integral_v<T>)
+			major <<= 5;
+			if (n < 24)
+				out.push_back(static_cast<std::uint8_t>(major | n));
+			else if (n <= 0xff)
 			{
-				if (is_array())
-					return std::get<array_ptr>(value)->at(index);
-				else
-					throw type_error("only array is valid");
+				out.push_back(major | 24);
+				putBigEndian(out, n, 1);
 			}
-			else if constexpr(std::is_constructible_v<string_t, T>) //T can be char* , std::string ...
+			else if (n <= 0xffff)
 			{
-				if (is_object())
-					return std::get<object_ptr>(value)->at(index);
-				else
-					throw type_error("only object is valid");
+				out.push_back(major | 25);
+				putBigEndian(out, n, 2);
+			}
+			else if (n <= 0xffffffff)
+			{
+				out.push_back(major | 26);
+				putBigEndian(out, n, 4);
+			}
+			else
+			{
+				out.push_back(major | 27);
+				putBigEndian(out, n, 8);
 			}
 		}
 
-		template<typename T>
-		const_reference at(T index) const
+		template<typename S>
+		static void appendBytes(std::vector<std::uint8_t>& out, const S& s)
 		{
-			if constexpr(std::is_integral_v<T>)
+			out.insert(out.end(),
+				reinterpret_cast<const std::uint8_t*>(s.data()),
+				reinterpret_cast<const std::uint8_t*>(s.data() + s.size()));
+		}
+
+		void writeCbor(std::vector<std::uint8_t>& out) const
+		{
+			switch (type)
 			{
-				if (is_array())
-					return std::get<array_ptr>(value)->at(index);
-				else
-					throw type_error("only array is valid");
+			case Json_type::Object:
+			{
+				const auto& object = *std::get<object_ptr>(value);
+				cborHead(out, 5, object.size());
+				for (const auto& element : object)
+				{
+					cborHead(out, 3, element.first.size());
+					appendBytes(out, element.first);
+					element.second.writeCbor(out);
+				}
+				break;
 			}
-			else if constexpr(std::is_constructible_v<string_t, T>)
+			case Json_type::Array:
 			{
-				if (is_object())
-					return std::get<object_ptr>(value)->at(index);
+				cborHead(out, 4, size());
+				forEachElement([&](const Basic_json& element)
+				{
+					element.writeCbor(out);
+				});
+				break;
+			}
+			case Json_type::String:
+			{
+				const auto& s = *std::get<string_ptr>(value);
+				cborHead(out, 3, s.size());
+				appendBytes(out, s);
+				break;
+			}
+			case Json_type::Interger:
+			{
+				const auto i = static_cast<std::int64_t>(std::get<interger_t>(value));
+				if (i >= 0)
+					cborHead(out, 0, static_cast<std::uint64_t>(i));
+				else //major type 1 encodes -1 - n
+					cborHead(out, 1, static_cast<std::uint64_t>(-(i + 1)));
+				break;
+			}
+			case Json_type::Float:
+			{
+				const auto d = static_cast<double>(std::get<float_t>(value));
+				if (fitsFloat(d))
+				{
+					out.push_back(0xfa);
+					putBigEndian(out, bitsOf(static_cast<float>(d)), 4);
+				}
 				else
-					throw type_error("only object is valid");
+				{
+					out.push_back(0xfb);
+					putBigEndian(out, bitsOf(d), 8);
+				}
+				break;
+			}
+			case Json_type::Boolean:
+				out.push_back(std::get<boolean_t>(value) ? 0xf5 : 0xf4);
+				break;
+			case Json_type::Null:
+				out.push_back(0xf6);
+				break;
+			default:
+				break;
 			}
 		}
 
-	private:
-
-		Json_type type;
-
-		Json_value value;
-
-	public:
-		constexpr Basic_json() noexcept : type(Json_type::Null) {}
-
-		template<typename U>
-		constexpr Basic_json(U val)
-			noexcept(std::is_nothrow_constructible_v<interger_t, U>
-				&& std::is_nothrow_constructible_v<float_t, U>)
+		static void msgpackHead(std::vector<std::uint8_t>& out, std::uint64_t n,
+			std::uint8_t fix, std::uint64_t fix_max, std::uint8_t first_wide, bool has_8bit)
 		{
-			if constexpr(std::is_integral_v<U>)
+			if (n <= fix_max)
+				out.push_back(static_cast<std::uint8_t>(fix | n));
+			else if (has_8bit && n <= 0xff)
 			{
-				type = Json_type::Interger;
-				value = interger_t(val);
+				out.push_back(first_wide);
+				putBigEndian(out, n, 1);
 			}
-			else if constexpr(std::is_floating_point_v<U>)
+			else if (n <= 0xffff)
 			{
-				type = Json_type::Float;
-				value = float_t(val);
+				out.push_back(static_cast<std::uint8_t>(first_wide + has_8bit));
+				putBigEndian(out, n, 2);
+			}
+			else
+			{
+				out.push_back(static_cast<std::uint8_t>(first_wide + has_8bit + 1));
+				putBigEndian(out, n, 4);
 			}
 		}
 
-		constexpr Basic_json(interger_t i)
-			noexcept(std::is_nothrow_constructible_v<interger_t, interger_t>)
-			: type(Json_type::Interger), value(i) {}
-
-		constexpr Basic_json(float_t f)
-			noexcept(std::is_nothrow_constructible_v<float_t, float_t>)
-			: type(Json_type::Float), value(f) {}
-
-		constexpr Basic_json(boolean_t b)
-			noexcept(std::is_nothrow_constructible_v<boolean_t, boolean_t>)
-			: type(Json_type::Boolean), value(b) {}
-
-		constexpr Basic_json(std::nullptr_t n) noexcept : type(Json_type::Null) {}
-
-		Basic_json(std::initializer_list<Basic_json> list)
+		void writeMsgpack(std::vector<std::uint8_t>& out) const
 		{
-			const auto is_object = std::all_of(list.begin(), list.end(), [](const auto& element)
+			switch (type)
 			{
-				return element.is_array() && element.size() == 2 && element[0].is_string();
-			});
-
-			if (is_object)
+			case Json_type::Object:
 			{
-				type = Json_type::Object;
-				value = std::make_unique<object_t>();
-				for (const auto& element : list)
-					std::get<object_ptr>(value)
-					->emplace(*std::get<string_ptr>(element[0].value), element[1]);
+				const auto& object = *std::get<object_ptr>(value);
+				msgpackHead(out, object.size(), 0x80, 15, 0xde, false);
+				for (const auto& element : object)
+				{
+					msgpackHead(out, element.first.size(), 0xa0, 31, 0xd9, true);
+					appendBytes(out, element.first);
+					element.second.writeMsgpack(out);
+				}
+				break;
 			}
-			else
+			case Json_type::Array:
 			{
-				type = Json_type::Array;
-				value = std::make_unique<array_t>(list.begin(), list.end());
+				msgpackHead(out, size(), 0x90, 15, 0xdc, false);
+				forEachElement([&](const Basic_json& element)
+				{
+					element.writeMsgpack(out);
+				});
+				break;
+			}
+			case Json_type::String:
+			{
+				const auto& s = *std::get<string_ptr>(value);
+				msgpackHead(out, s.size(), 0xa0, 31, 0xd9, true);
+				appendBytes(out, s);
+				break;
+			}
+			case Json_type::Interger:
+			{
+				const auto i = static_cast<std::int64_t>(std::get<interger_t>(value));
+				if (i >= 0)
+				{
+					const auto n = static_cast<std::uint64_t>(i);
+					if (n < 0x80) //positive fixint
+						out.push_back(static_cast<std::uint8_t>(n));
+					else if (n <= 0xff)
+					{
+						out.push_back(0xcc);
+						putBigEndian(out, n, 1);
+					}
+					else if (n <= 0xffff)
+					{
+						out.push_back(0xcd);
+						putBigEndian(out, n, 2);
+					}
+					else if (n <= 0xffffffff)
+					{
+						out.push_back(0xce);
+						putBigEndian(out, n, 4);
+					}
+					else
+					{
+						out.push_back(0xcf);
+						putBigEndian(out, n, 8);
+					}
+				}
+				else
+				{
+					const auto n = static_cast<std::uint64_t>(i);
+					if (i >= -32) //negative fixint
+						out.push_back(static_cast<std::uint8_t>(n));
+					else if (i >= std::numeric_limits<std::int8_t>::min())
+					{
+						out.push_back(0xd0);
+						putBigEndian(out, n, 1);
+					}
+					else if (i >= std::numeric_limits<std::int16_t>::min())
+					{
+						out.push_back(0xd1);
+						putBigEndian(out, n, 2);
+					}
+					else if (i >= std::numeric_limits<std::int32_t>::min())
+					{
+						out.push_back(0xd2);
+						putBigEndian(out, n, 4);
+					}
+					else
+					{
+						out.push_back(0xd3);
+						putBigEndian(out, n, 8);
+					}
+				}
+				break;
+			}
+			case Json_type::Float:
+			{
+				const auto d = static_cast<double>(std::get<float_t>(value));
+				if (fitsFloat(d))
+				{
+					out.push_back(0xca);
+					putBigEndian(out, bitsOf(static_cast<float>(d)), 4);
+				}
+				else
+				{
+					out.push_back(0xcb);
+					putBigEndian(out, bitsOf(d), 8);
+				}
+				break;
+			}
+			case Json_type::Boolean:
+				out.push_back(std::get<boolean_t>(value) ? 0xc3 : 0xc2);
+				break;
+			case Json_type::Null:
+				out.push_back(0xc0);
+				break;
+			default:
+				break;
 			}
 		}
 
-		Basic_json(const object_t& o) :type(Json_type::Object), value(std::make_unique<object_t>(o)) {}
-
-		Basic_json(const array_t& a) :type(Json_type::Array), value(std::make_unique<array_t>(a)) {}
+	public:
+		std::vector<std::uint8_t> to_snapshot() const
+		{
+			std::vector<std::uint8_t> out(sizeof(Snapshot_header));
+			const auto root = writeSnapshot(out);
+			Snapshot_header header{};
+			std::memcpy(header.magic, "JSNP", 4);
+			header.byte_order = snapshot_byte_order;
+			header.version = snapshot_version;
+			header.size = out.size();
+			header.root = root;
+			std::memcpy(out.data(), &header, sizeof(header));
+			return out;
+		}
 
-		Basic_json(const string_t& s) :type(Json_type::String), value(std::make_unique<string_t>(s)) {}
+		void write_snapshot(const std::string& path) const
+		{
+			const auto image = to_snapshot();
+			std::ofstream f(path, std::ios::binary);
+			f.write(reinterpret_cast<const char*>(image.data()), image.size());
+			if (!f)
+				throw input_error("cannot write snapshot file");
+		}
+	private:
+		static std::uint64_t snapshotAlloc(std::vector<std::uint8_t>& out, size_t bytes)
+		{
+			const auto offset = (out.size() + 7) & ~size_t(7); //keep every record 8-byte aligned
+			out.resize(offset + bytes);
+			return offset;
+		}
 
-		Basic_json(const char* s) :type(Json_type::String), value(std::make_unique<string_t>(s)) {}
+		template<typename S>
+		static std::uint64_t snapshotString(std::vector<std::uint8_t>& out, const S& s)
+		{
+			const auto offset = snapshotAlloc(out, s.size() + 1); //nul terminated for c apis
+			std::memcpy(out.data() + offset, s.data(), s.size());
+			return offset;
+		}
 
-		Basic_json(std::string_view sv) :type(Json_type::String), value(std::make_unique<string_t>(sv)) {}
+		template<typename S>
+		static std::uint32_t snapshotSize(const S& s)
+		{
+			if (s.size() > std::numeric_limits<std::uint32_t>::max())
+				throw type_error("too large for a snapshot");
+			return static_cast<std::uint32_t>(s.size());
+		}
 
-		Basic_json(Json_type t) :type(t)
+		Snapshot_node writeSnapshot(std::vector<std::uint8_t>& out) const
 		{
+			Snapshot_node node{ static_cast<std::uint32_t>(type), 0, 0 };
 			switch (type)
 			{
 			case Json_type::Object:
-				value = std::make_unique<object_t>();
+			{
+				const auto& object = *std::get<object_ptr>(value);
+				std::vector<const typename object_t::value_type*> members;
+				members.reserve(object.size());
+				for (const auto& element : object)
+					members.push_back(&element);
+				std::sort(members.begin(), members.end(), [](auto a, auto b)
+				{
+					return std::string_view(a->first.data(), a->first.size())
+						< std::string_view(b->first.data(), b->first.size());
+				});
+				node.size = snapshotSize(object);
+				node.payload = snapshotAlloc(out, members.size() * sizeof(Snapshot_entry));
+				for (size_t i = 0; i < members.size(); ++i)
+				{
+					Snapshot_entry entry{};
+					entry.key_size = snapshotSize(members[i]->first);
+					entry.key_offset = snapshotString(out, members[i]->first);
+					entry.value = members[i]->second.writeSnapshot(out);
+					//children are appended behind the table, so write through offsets only
+					std::memcpy(out.data() + node.payload + i * sizeof(Snapshot_entry), &entry, sizeof(entry));
+				}
 				break;
+			}
 			case Json_type::Array:
-				value = std::make_unique<array_t>();
+			{
+				node.size = snapshotSize(*this);
+				node.payload = snapshotAlloc(out, size() * sizeof(Snapshot_node));
+				for (size_t i = 0; i < size(); ++i)
+				{
+					const auto child = withElement(i, [&](const Basic_json& element)
+					{
+						return element.writeSnapshot(out);
+					});
+					std::memcpy(out.data() + node.payload + i * sizeof(Snapshot_node), &child, sizeof(child));
+				}
 				break;
+			}
 			case Json_type::String:
-				value = std::make_unique<string_t>();
+			{
+				const auto& s = *std::get<string_ptr>(value);
+				node.size = snapshotSize(s);
+				node.payload = snapshotString(out, s);
 				break;
+			}
 			case Json_type::Interger:
-				value = static_cast<interger_t>(0);
+				node.payload = static_cast<std::uint64_t>(static_cast<std::int64_t>(std::get<interger_t>(value)));
 				break;
 			case Json_type::Float:
-				value = static_cast<float_t>(0);
+				node.payload = bitsOf(static_cast<double>(std::get<float_t>(value)));
 				break;
 			case Json_type::Boolean:
-				value = false;
-				break;
-			case Json_type::Null:
+				node.payload = std::get<boolean_t>(value) ? 1 : 0;
 				break;
 			default:
 				break;
 			}
+			return node;
 		}
 
-		Basic_json(const Basic_json& other)
+		class BinaryInput //bounds-checked cursor shared by the binary readers, and their Parse_limits
 		{
-			*this = other;
-		}
+		public:
+			BinaryInput(const std::uint8_t* data, size_type size, const Parse_limits& limits)
+				: pos(data), end(data + size), parse_limits(limits)
+			{
+				if (size > parse_limits.max_document_size)
+					throw input_error(Parse_error{ Parse_errc::Document_too_large });
+			}
 
-		reference operator=(const Basic_json& other)
+			std::uint8_t next()
+			{
+				if (pos == end)
+					throw input_error("unexpected end of binary input");
+				return *pos++;
+			}
+
+			std::uint8_t peek() const
+			{
+				if (pos == end)
+					throw input_error("unexpected end of binary input");
+				return *pos;
+			}
+
+			std::uint64_t readBigEndian(int bytes)
+			{
+				if (end - pos < bytes)
+					throw input_error("unexpected end of binary input");
+				std::uint64_t n = 0;
+				for (int i = 0; i < bytes; ++i)
+					n = (n << 8) | *pos++;
+				return n;
+			}
+
+			void readString(string_t& s, std::uint64_t len)
+			{
+				if (static_cast<std::uint64_t>(end - pos) < len)
+					throw input_error("unexpected end of binary input");
+				if (len > parse_limits.max_string_length - std::min(s.size(), parse_limits.max_string_length))
+					throw input_error(Parse_error{ Parse_errc::String_too_long });
+				s.append(reinterpret_cast<const char*>(pos), static_cast<size_t>(len));
+				pos += len;
+			}
+
+			size_type remaining() const noexcept
+			{
+				return static_cast<size_type>(end - pos);
+			}
+
+			void checkDepth(size_t depth) const //the readers recurse once per level
+			{
+				if (depth > parse_limits.max_depth)
+					throw input_error(Parse_error{ Parse_errc::Nesting_too_deep });
+			}
+
+			void checkElements(std::uint64_t n) const //elements of an array or members of an object
+			{
+				if (n > parse_limits.max_elements)
+					throw input_error(Parse_error{ Parse_errc::Too_many_elements });
+			}
+
+			static interger_t toInterger(std::uint64_t n)
+			{
+				if (n > static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max()))
+					throw input_error("integer out of range");
+				return static_cast<interger_t>(n);
+			}
+
+			template<typename T>
+			static float_t toFloat(std::uint64_t bits) noexcept
+			{
+				T f;
+				if constexpr(sizeof(T) == 4)
+				{
+					const auto b = static_cast<std::uint32_t>(bits);
+					std::memcpy(&f, &b, sizeof(f));
+				}
+				else
+					std::memcpy(&f, &bits, sizeof(f));
+				return static_cast<float_t>(f);
+			}
+
+		private:
+			const std::uint8_t* pos;
+			const std::uint8_t* end;
+			Parse_limits parse_limits;
+		};
+
+		class CborReader
 		{
-			if (this != &other)
+		public:
+			CborReader(const std::uint8_t* data, size_type size, const Parse_limits& limits)
+				: input(data, size, limits) {}
+
+			Basic_json parse()
 			{
-				type = other.type;
-				switch (type)
+				auto result = parseValue(0);
+				if (input.remaining() != 0)
+					throw input_error("trailing bytes after cbor value");
+				return result;
+			}
+		private:
+			static constexpr std::uint8_t indefinite = 31;
+			static constexpr std::uint8_t break_code = 0xff;
+
+			std::uint64_t readArgument(std::uint8_t info)
+			{
+				if (info < 24)
+					return info;
+				switch (info)
 				{
-				case Json_type::Object:
-					value = std::make_unique<object_t>(*std::get<object_ptr>(other.value));
-					break;
-				case Json_type::Array:
-					value = std::make_unique<array_t>(*std::get<array_ptr>(other.value));
-					break;
-				case Json_type::String:
-					value = std::make_unique<string_t>(*std::get<string_ptr>(other.value));
-					break;
-				case Json_type::Interger:
-					value = std::get<interger_t>(other.value);
-					break;
-				case Json_type::Float:
-					value = std::get<float_t>(other.value);
-					break;
-				case Json_type::Boolean:
-					value = std::get<boolean_t>(other.value);
-					break;
-				case Json_type::Null:
-					break;
+				case 24:
+					return input.readBigEndian(1);
+				case 25:
+					return input.readBigEndian(2);
+				case 26:
+					return input.readBigEndian(4);
+				case 27:
+					return input.readBigEndian(8);
 				default:
-					break;
+					throw input_error("invalid cbor length");
 				}
 			}
-			return *this;
-		}
 
-		Basic_json(Basic_json&& other) noexcept
-			:type(other.type), value(std::move(other.value))
-		{
+			bool atBreak()
+			{
+				if (input.peek() != break_code)
+					return false;
+				input.next();
+				return true;
+			}
 
-		}
+			void readText(string_t& s, std::uint8_t info)
+			{
+				if (info != indefinite)
+				{
+					input.readString(s, readArgument(info));
+					return;
+				}
+				while (!atBreak()) //indefinite text is a sequence of definite chunks
+				{
+					const auto chunk = input.next();
+					if (chunk >> 5 != 3 || (chunk & 0x1f) == indefinite)
+						throw input_error("invalid cbor string chunk");
+					input.readString(s, readArgument(chunk & 0x1f));
+				}
+			}
 
-		reference operator=(Basic_json&& other) noexcept
+			static float_t halfToFloat(std::uint64_t half) noexcept
+			{
+				const auto exponent = static_cast<int>((half >> 10) & 0x1f);
+				const auto mantissa = static_cast<double>(half & 0x3ff);
+				double d;
+				if (exponent == 0)
+					d = std::ldexp(mantissa, -24);
+				else if (exponent == 31)
+					d = mantissa == 0 ? std::numeric_limits<double>::infinity()
+					: std::numeric_limits<double>::quiet_NaN();
+				else
+					d = std::ldexp(mantissa + 1024, exponent - 25);
+				return static_cast<float_t>(half & 0x8000 ? -d : d);
+			}
+
+			Basic_json parseValue(size_t depth)
+			{
+				const auto initial = input.next();
+				const std::uint8_t info = initial & 0x1f;
+				switch (initial >> 5)
+				{
+				case 0: //unsigned integer
+					return Basic_json(BinaryInput::toInterger(readArgument(info)));
+				case 1: //negative integer
+					return Basic_json(static_cast<interger_t>(
+						-1 - static_cast<std::int64_t>(BinaryInput::toInterger(readArgument(info)))));
+				case 3:
+				{
+					Basic_json s(Json_type::String);
+					readText(*std::get<string_ptr>(s.value), info);
+					return s;
+				}
+				case 4:
+				{
+					input.checkDepth(depth + 1);
+					Basic_json array(Json_type::Array);
+					auto& elements = *std::get<array_ptr>(array.value);
+					if (info == indefinite)
+					{
+						while (!atBreak())
+						{
+							input.checkElements(elements.size() + 1);
+							elements.push_back(parseValue(depth + 1));
+						}
+					}
+					else
+					{
+						const auto n = readArgument(info);
+						input.checkElements(n);
+						//every element takes at least one byte, never trust n beyond that
+						elements.reserve(static_cast<size_t>(
+							std::min<std::uint64_t>(n, input.remaining())));
+						for (std::uint64_t i = 0; i < n; ++i)
+							elements.push_back(parseValue(depth + 1));
+					}
+					array.pack();
+					return array;
+				}
+				case 5:
+				{
+					input.checkDepth(depth + 1);
+					Basic_json object(Json_type::Object);
+					auto& members = *std::get<object_ptr>(object.value);
+					const bool is_indefinite = info == indefinite;
+					const auto n = is_indefinite ? 0 : readArgument(info);
+					input.checkElements(n);
+					for (std::uint64_t i = 0; is_indefinite ? !atBreak() : i < n; ++i)
+					{
+						input.checkElements(i + 1);
+						const auto key_head = input.next();
+						if (key_head >> 5 != 3)
+							throw input_error("cbor map key must be a text string");
+						string_t name;
+						readText(name, key_head & 0x1f);
+						members.emplace(std::move(name), parseValue(depth + 1));
+					}
+					return object;
+				}
+				case 6: //semantic tag, the tagged item is kept as is; a tag chain nests too
+					input.checkDepth(depth + 1);
+					readArgument(info);
+					return parseValue(depth + 1);
+				case 7:
+					switch (info)
+					{
+					case 20:
+						return Basic_json(false);
+					case 21:
+						return Basic_json(true);
+					case 22:
+					case 23: //undefined
+						return Basic_json(nullptr);
+					case 25:
+						return Basic_json(halfToFloat(input.readBigEndian(2)));
+					case 26:
+						return Basic_json(BinaryInput::template toFloat<float>(input.readBigEndian(4)));
+					case 27:
+						return Basic_json(BinaryInput::template toFloat<double>(input.readBigEndian(8)));
+					default:
+						throw input_error("unsupported cbor simple value");
+					}
+				default: //byte strings have no json counterpart
+					throw input_error("unsupported cbor major type");
+				}
+			}
+
+			BinaryInput input;
+		};
+
+		class MsgpackReader
 		{
-			if (this != &other)
+		public:
+			MsgpackReader(const std::uint8_t* data, size_type size, const Parse_limits& limits)
+				: input(data, size, limits) {}
+
+			Basic_json parse()
 			{
-				type = other.type;
-				value = std::move(other.value);
+				auto result = parseValue(0);
+				if (input.remaining() != 0)
+					throw input_error("trailing bytes after msgpack value");
+				return result;
 			}
-			return *this;
+		private:
+			Basic_json parseString(std::uint64_t len)
+			{
+				Basic_json s(Json_type::String);
+				input.readString(*std::get<string_ptr>(s.value), len);
+				return s;
+			}
+
+			Basic_json parseArray(std::uint64_t n, size_t depth)
+			{
+				input.checkDepth(depth);
+				input.checkElements(n);
+				Basic_json array(Json_type::Array);
+				auto& elements = *std::get<array_ptr>(array.value);
+				elements.reserve(static_cast<size_t>(std::min<std::uint64_t>(n, input.remaining())));
+				for (std::uint64_t i = 0; i < n; ++i)
+					elements.push_back(parseValue(depth));
+				array.pack();
+				return array;
+			}
+
+			Basic_json parseObject(std::uint64_t n, size_t depth)
+			{
+				input.checkDepth(depth);
+				input.checkElements(n);
+				Basic_json object(Json_type::Object);
+				auto& members = *std::get<object_ptr>(object.value);
+				for (std::uint64_t i = 0; i < n; ++i)
+				{
+					const auto key_head = input.next();
+					std::uint64_t len;
+					if ((key_head & 0xe0) == 0xa0)
+						len = key_head & 0x1f;
+					else if (key_head >= 0xd9 && key_head <= 0xdb)
+						len = input.readBigEndian(1 << (key_head - 0xd9));
+					else
+						throw input_error("msgpack map key must be a string");
+					string_t name;
+					input.readString(name, len);
+					members.emplace(std::move(name), parseValue(depth));
+				}
+				return object;
+			}
+
+			static interger_t signExtend(std::uint64_t n, int bytes) noexcept
+			{
+				const int shift = 64 - bytes * 8;
+				return static_cast<interger_t>(static_cast<std::int64_t>(n << shift) >> shift);
+			}
+
+			Basic_json parseValue(size_t depth)
+			{
+				const auto head = input.next();
+				if (head < 0x80) //positive fixint
+					return Basic_json(static_cast<interger_t>(head));
+				if (head >= 0xe0) //negative fixint
+					return Basic_json(static_cast<interger_t>(static_cast<std::int8_t>(head)));
+				if ((head & 0xf0) == 0x80)
+					return parseObject(head & 0x0f, depth + 1);
+				if ((head & 0xf0) == 0x90)
+					return parseArray(head & 0x0f, depth + 1);
+				if ((head & 0xe0) == 0xa0)
+					return parseString(head & 0x1f);
+				switch (head)
+				{
+				case 0xc0:
+					return Basic_json(nullptr);
+				case 0xc2:
+					return Basic_json(false);
+				case 0xc3:
+					return Basic_json(true);
+				case 0xca:
+					return Basic_json(BinaryInput::template toFloat<float>(input.readBigEndian(4)));
+				case 0xcb:
+					return Basic_json(BinaryInput::template toFloat<double>(input.readBigEndian(8)));
+				case 0xcc:
+				case 0xcd:
+				case 0xce:
+				case 0xcf:
+					return Basic_json(BinaryInput::toInterger(input.readBigEndian(1 << (head - 0xcc))));
+				case 0xd0:
+				case 0xd1:
+				case 0xd2:
+				case 0xd3:
+				{
+					const int bytes = 1 << (head - 0xd0);
+					return Basic_json(signExtend(input.readBigEndian(bytes), bytes));
+				}
+				case 0xd9:
+				case 0xda:
+				case 0xdb:
+					return parseString(input.readBigEndian(1 << (head - 0xd9)));
+				case 0xdc:
+					return parseArray(input.readBigEndian(2), depth + 1);
+				case 0xdd:
+					return parseArray(input.readBigEndian(4), depth + 1);
+				case 0xde:
+					return parseObject(input.readBigEndian(2), depth + 1);
+				case 0xdf:
+					return parseObject(input.readBigEndian(4), depth + 1);
+				default: //bin and ext families have no json counterpart
+					throw input_error("unsupported msgpack type");
+				}
+			}
+
+			BinaryInput input;
+		};
+
+	public:
+
+		static value_type parse(const string_t& s, InputMode mode = InputMode::String)
+		{
+			return localParser().parse(s, mode);
 		}
 
-		~Basic_json() = default;
+		static value_type parse(const string_t& s, const Parse_limits& limits, InputMode mode = InputMode::String)
+		{
+			Parser parser(limits);
+			return parser.parse(s, mode);
+		}
 
-		bool operator==(const Basic_json& other) const noexcept
+		static value_type parse(const string_t& s, const Schema& schema)
 		{
-			return type == other.type && value == other.value;
+			return localParser().parse(s, schema);
 		}
 
-		bool operator!=(const Basic_json& other) const noexcept
+		static value_type parse(const string_t& s, const Projection& projection)
 		{
-			return !(*this == other);
+			return localParser().parse(s, projection);
 		}
 
-	public:
-		string_t stringify() const
+		//reports malformed input through the result instead of input_error
+		static Parse_error try_parse(const string_t& s, value_type& root, InputMode mode = InputMode::String)
 		{
-			string_t s;
-			if (type == Json_type::Object)
-				stringifyObject(s, 1);
-			else if (type == Json_type::Array)
-				stringifyArray(s, 1);
-			return s;
+			return localParser().try_parse(s, mode, root);
 		}
-	private:
-		void addSpace(string_t& s, int num) const
+
+		//parses the elements of a top-level array concurrently; any other document parses serially
+		static value_type parse_parallel(std::string_view s, Thread_pool& pool = Thread_pool::shared())
 		{
-			for (int i = 0; i < num; ++i)
-				s += "  ";
+			return parse_parallel(s, Parse_limits(), pool);
 		}
-		void stringifyObject(string_t& s, int depth) const
+
+		static value_type parse_parallel(std::string_view s, const Parse_limits& limits,
+			Thread_pool& pool = Thread_pool::shared())
 		{
-			s += "{\n";
-			addSpace(s, depth);
-			for (const auto& element : *std::get<object_ptr>(value))
+			std::vector<std::pair<size_t, size_t>> elements;
+			if (pool.size() == 1 || s.size() > limits.max_document_size || !scanElements(s, elements)
+				|| elements.size() < 2 || elements.size() > limits.max_elements) //fails as the serial parse does
+				return Parser(limits).parse(s);
+			//a few chunks per worker so stealing can even out uneven elements
+			const auto chunk_count = std::min(elements.size(), pool.size() * 8);
+			Basic_json array(Json_type::Array);
+			auto& result = *std::get<array_ptr>(array.value);
+			result.resize(elements.size());
+			std::atomic<bool> failed{ false };
+			pool.parallel_for(chunk_count, [&](size_t chunk)
 			{
-				s += '"';
-				s += element.first;
-				s += "\": ";
-				switch (element.second.type)
-				{
-				case Json_type::Object:
-					element.second.stringifyObject(s, depth + 1);
-					break;
-				case Json_type::Array:
-					element.second.stringifyArray(s, depth + 1);
-					break;
-				case Json_type::String:
-				{
-					s += "\"";
-					s += *std::get<string_ptr>(element.second.value);
-					s += "\"";
-					break;
-				}
-				case Json_type::Interger:
-					s += std::to_string(
-						std::get<interger_t>(element.second.value));
-					break;
-				case Json_type::Float:
-					s += std::to_string(
-						std::get<float_t>(element.second.value));
-					break;
-				case Json_type::Boolean:
+				Parser parser(limits);
+				const auto last = elements.size() * (chunk + 1) / chunk_count;
+				for (auto i = elements.size() * chunk / chunk_count; i < last && !failed.load(std::memory_order_relaxed); ++i)
 				{
-					if (std::get<boolean_t>(element.second.value) == true)
-						s += "true";
-					else
-						s += "false";
-					break;
-				}
-				case Json_type::Null:
-					s += "null";
-					break;
-				default:
-					break;
+					const auto [first, size] = elements[i];
+					if (parser.parseElement(s.substr(first, size), result[i], 1))
+						failed.store(true, std::memory_order_relaxed);
 				}
-				s += ",\n";
-				addSpace(s, depth);
-			}
-			s += '}';
+			});
+			if (failed) //the serial parse reports the first error in the input, whichever task saw one
+				return Parser(limits).parse(s);
+			array.pack();
+			return array;
 		}
-		void stringifyArray(string_t& s, int depth) const
+	private:
+		static Parser& localParser() //one parser per thread, nothing is shared between threads
 		{
-			s += "[\n";
-			addSpace(s, depth);
-			for (const auto& element : *std::get<array_ptr>(value))
+			thread_local Parser parser;
+			return parser;
+		}
+
+		//structural pre-scan: [offset, length) of every element of a top-level array. returns
+		//false when the document is not an array or is malformed, for the serial parse to report
+		static bool scanElements(std::string_view s, std::vector<std::pair<size_t, size_t>>& elements)
+		{
+			const auto is_space = [](char c)
 			{
-				switch (element.type)
-				{
-				case Json_type::Object:
-					element.stringifyObject(s, depth + 1);
-					break;
-				case Json_type::Array:
-					element.stringifyArray(s, depth + 1);
-					break;
-				case Json_type::String:
+				return std::isspace(static_cast<unsigned char>(c)) != 0;
+			};
+			size_t i = 0;
+			while (i < s.size() && is_space(s[i]))
+				++i;
+			if (i == s.size() || s[i] != '[')
+				return false;
+			std::vector<char> closers; //of the containers inside the top-level array
+			size_t begin = ++i;
+			for (; i < s.size(); ++i)
+			{
+				switch (s[i])
 				{
-					s += "\"";
-					s += *std::get<string_ptr>(element.value);
-					s += "\"";
-					break;
-				}
-				case Json_type::Interger:
-					s += std::to_string(std::get<interger_t>(element.value));
+				case '"':
+					for (++i; i < s.size() && s[i] != '"'; ++i)
+						if (s[i] == '\\')
+							++i;
+					if (i >= s.size())
+						return false;
 					break;
-				case Json_type::Float:
-					s += std::to_string(std::get<float_t>(element.value));
+				case '[':
+					closers.push_back(']');
 					break;
-				case Json_type::Boolean:
-				{
-					if (std::get<boolean_t>(element.value) == true)
-						s += "true";
-					else
-						s += "false";
+				case '{':
+					closers.push_back('}');
 					break;
-				}
-				case Json_type::Null:
-					s += "null";
+				case ']':
+				case '}':
+					if (!closers.empty())
+					{
+						if (closers.back() != s[i])
+							return false;
+						closers.pop_back();
+						break;
+					}
+					if (s[i] != ']')
+						return false;
+					//a blank last slot is an empty array or the ',' stringify() leaves before ']'
+					if (!std::all_of(s.begin() + begin, s.begin() + i, is_space))
+						elements.emplace_back(begin, i - begin);
+					for (++i; i < s.size(); ++i)
+						if (!is_space(s[i]))
+							return false;
+					return true;
+				case ',':
+					if (closers.empty())
+					{
+						elements.emplace_back(begin, i - begin);
+						begin = i + 1;
+					}
 					break;
 				default:
 					break;
 				}
-				s += ",\n";
-				addSpace(s, depth);
 			}
-			s += ']';
-		}
-	public:
-
-		static value_type parse(const string_t& s, InputMode mode = InputMode::String)
-		{
-			return parser.parse(s, mode);
+			return false;
 		}
 	};
 
 	using Json = Basic_json<>;
 
-	template<>
-	Json::Parser Json::parser{};
-
-	Json operator""_json(const char* str, size_t len)
+	//checked and laid out while compiling: a malformed literal does not compile, and the view
+	//reads the image in place. Json j = "..."_json; copies it into a mutable document
+	template<Fixed_string S>
+	Json_view operator""_json() noexcept
 	{
-		return Json::parse(str);
+		return Static_json<S>::root();
 	}
 
 
@@ -1,36 +1,452 @@
 #include "json.h"
-#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
 
 using namespace jasoon;
-using namespace std::chrono;
 
-void test()
+#ifndef JASOON_DATA_DIR
+#define JASOON_DATA_DIR "."
+#endif
+
+//kept out of line: once inlined, gcc pairs malloc with operator delete and warns of a mismatch
+#if defined(__GNUC__)
+#define NOINLINE [[gnu::noinline]]
+#else
+#define NOINLINE
+#endif
+
+static size_t allocations = 0; //counts every operator new of the process
+
+NOINLINE void* operator new(size_t n)
+{
+	++allocations;
+	if (void* p = std::malloc(n))
+		return p;
+	throw std::bad_alloc();
+}
+
+NOINLINE void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+NOINLINE void operator delete(void* p, size_t) noexcept
+{
+	std::free(p);
+}
+
+std::string data_file(const char* name) //sample documents live in JASOON_DATA_DIR, set by the build
+{
+	return std::string(JASOON_DATA_DIR) + "/" + name;
+}
+
+std::string read_data(const char* name)
+{
+	std::ifstream f(data_file(name), std::ios::binary);
+	if (!f)
+		throw std::runtime_error(data_file(name) + " not found, the demo reads it from JASOON_DATA_DIR");
+	return std::string((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+}
+
+constexpr Snapshot_header static_header(std::string_view s) //of the image a "..."_json literal compiles to
+{
+	const auto image = Static_parser::build(s);
+	std::array<std::uint8_t, sizeof(Snapshot_header)> bytes{};
+	std::copy_n(image.begin(), bytes.size(), bytes.begin());
+	return std::bit_cast<Snapshot_header>(bytes);
+}
+
+static_assert(static_header(R"({"a": [1, 2.5, "x"], "b": null, "a": 0})").root.type == static_cast<std::uint32_t>(Json_type::Object)
+	&& static_header(R"({"a": [1, 2.5, "x"], "b": null, "a": 0})").root.size == 2, "duplicate names are dropped");
+static_assert(static_header("[1, [], {},]").root.size == 3 && static_header(" [] ").size == sizeof(Snapshot_header),
+	"a trailing ',' is allowed and an empty root needs no payload");
+
+void test_pool() //same-shaped payloads must not touch the allocator once the pools are warm
+{
+	const auto s = read_data("citm_catalog.json");
+	Json::Parser parser;
+	Json::Document doc;
+	for (int i = 0; i < 3; ++i) //warm up the free lists
+		parser.parse(s, doc);
+	const auto before = allocations;
+	parser.parse(s, doc);
+	const auto steady = allocations - before;
+	std::cout << "steady state allocations: " << steady << '\n';
+	if (steady != 0)
+		throw std::logic_error("document pool allocated in steady state");
+}
+
+void test_parallel_stringify() //must match stringify() byte for byte at every pool size
 {
-	std::ifstream f("citm_catalog.json");
-	char c;
-	std::string s;
-	while (!f.eof())
+	const auto s = read_data("citm_catalog.json");
+	auto j = Json::parse(s);
+	const auto serial = j.stringify();
+	for (unsigned threads = 1; threads <= 4; ++threads)
 	{
-		f >> c;
-		s += c;
+		Thread_pool pool(threads);
+		if (j.stringify_parallel(pool) != serial)
+			throw std::logic_error("parallel stringify differs from stringify");
 	}
-	//std::cout << static_cast<int>(s[0]);
-	auto start = system_clock::now();
-	auto j = Json::parse(s);
-	auto end = system_clock::now();
-	std::cout << duration_cast<milliseconds>(end - start).count();
-	//std::cout << j.stringify();
+}
+
+void test_parallel_parse() //must read back what stringify() writes, trailing ',' included
+{
+	const auto s = read_data("data.json");
+	const auto j = Json::parse("[" + s + "," + s + "," + s + "," + s + "]");
+	Thread_pool pool(4);
+	if (!(Json::parse_parallel(j.stringify(), pool) == j))
+		throw std::logic_error("parallel parse differs from parse");
+	if (!(Json::parse_parallel("[1, 2, 3,]", pool) == Json::parse("[1, 2, 3,]")))
+		throw std::logic_error("parallel parse rejects a trailing comma");
+	if (!Json::parse_parallel("[1, 2, 3]", pool).is_packed() || !Json::from_cbor(Json::parse("[1.5, 2.5]").to_cbor()).is_packed())
+		throw std::logic_error("numeric array is not packed like Json::parse packs it");
+	try
+	{
+		Json::parse_parallel("[1,,2]", pool);
+	}
+	catch (const input_error&)
+	{
+		return;
+	}
+	throw std::logic_error("parallel parse accepts an empty element");
+}
+
+void test_parallel_parse_errors() //malformed input fails with the error the serial parse reports
+{
+	Thread_pool pool(4);
+	for (const auto text : { R"([1, {"a": [1,2}, 3])", "[1,2,3", "[[1], 2,, 3]", "[1,,2]", "[1, 2] x",
+		"[\"a\", \"b]", "[1, tru, 3]", "[{\"a\" 1}, 2]", "[1, 2}", "[[1}, 2]" })
+	{
+		Json root;
+		const auto serial = Json::try_parse(text, root);
+		try
+		{
+			Json::parse_parallel(text, pool);
+		}
+		catch (const input_error& e)
+		{
+			const auto& parallel = e.error();
+			if (parallel.code == serial.code && parallel.offset == serial.offset
+				&& parallel.line == serial.line && parallel.column == serial.column)
+				continue;
+		}
+		throw std::logic_error(std::string("parallel parse reports another error for ") + text);
+	}
+}
+
+void test_parse_errors() //each failure has its code and the offset of the token at fault, and prints nothing
+{
+	struct Case
+	{
+		std::string_view text;
+		Parse_errc code;
+		size_t offset;
+		Parse_limits limits = {};
+	};
+	const Case cases[] = {
+		{ "[1, @]", Parse_errc::Unexpected_character, 4 },
+		{ R"(["abc)", Parse_errc::Unterminated_string, 5 },
+		{ "[1.5e999]", Parse_errc::Invalid_number, 1 },
+		{ "[tru]", Parse_errc::Invalid_literal, 1 },
+		{ R"({"a": })", Parse_errc::Value_expected, 6 },
+		{ "{1: 2}", Parse_errc::Name_expected, 1 },
+		{ R"({"a" 1})", Parse_errc::Name_separator_expected, 5 },
+		{ R"({"a": 1)", Parse_errc::Object_end_expected, 7 },
+		{ "[1, 2", Parse_errc::Array_end_expected, 5 },
+		{ "1", Parse_errc::Root_expected, 0 },
+		{ "[1] 2", Parse_errc::Trailing_characters, 4 },
+		{ "[[[]]]", Parse_errc::Nesting_too_deep, 2, { .max_depth = 2 } },
+		{ "[1, 2]", Parse_errc::Document_too_large, 0, { .max_document_size = 5 } },
+		{ R"(["abcd"])", Parse_errc::String_too_long, 1, { .max_string_length = 3 } },
+		{ "[1, 2, 3]", Parse_errc::Too_many_elements, 7, { .max_elements = 2 } },
+	};
+	std::ostringstream printed;
+	const auto cerr_buffer = std::cerr.rdbuf(printed.rdbuf());
+	for (const auto& c : cases)
+	{
+		Json root;
+		const auto error = Json::Parser(c.limits).try_parse(c.text, root);
+		const auto has_position = c.code != Parse_errc::Document_too_large; //refused before reading
+		if (error.code != c.code || error.offset != c.offset
+			|| error.line != (has_position ? 1 : 0) || error.column != (has_position ? c.offset + 1 : 0))
+		{
+			std::cerr.rdbuf(cerr_buffer);
+			throw std::logic_error(std::string("wrong error for ") + std::string(c.text));
+		}
+	}
+	Json root;
+	const auto error = Json::try_parse("{\n\t\"a\": [1,\n\t\t2 3]\n}", root);
+	const auto missing = Json::try_parse("no_such_file.json", root, InputMode::File);
+	std::cerr.rdbuf(cerr_buffer);
+	if (error.code != Parse_errc::Array_end_expected || error.offset != 16 || error.line != 3 || error.column != 5)
+		throw std::logic_error("wrong position for an error on a later line");
+	if (missing.code != Parse_errc::Cannot_open_file || missing.line != 0)
+		throw std::logic_error("missing file is not reported");
+	if (!printed.str().empty())
+		throw std::logic_error("a failed parse printed to std::cerr");
+}
+
+#ifdef JASOON_ENABLE_STATS
+void test_stats() //counts of a small known document, and a warm Document makes no nodes
+{
+	const std::string_view s = R"({"a": [1, 2.5, true, null], "b": "xy"})";
+	Json::Parser parser;
+	const auto j = parser.parse(s);
+	const auto& p = parser.stats();
+	const auto token = [&](Token t) { return p.tokens[static_cast<size_t>(t)]; };
+	const auto node = [](const auto& stats, Json_type t) { return stats.nodes[static_cast<size_t>(t)]; };
+	if (p.bytes != s.size() || p.max_depth != 2 || p.string_bytes != 4 || p.node_allocations != 5
+		|| token(Token::Object_begin) != 1 || token(Token::Array_end) != 1 || token(Token::Name_separator) != 2
+		|| token(Token::Value_separator) != 4 || token(Token::String) != 3 || token(Token::Float) != 1
+		|| token(Token::False) != 0 || node(p, Json_type::Object) != 1 || node(p, Json_type::String) != 1
+		|| node(p, Json_type::Boolean) != 1 || node(p, Json_type::Null) != 1)
+		throw std::logic_error("parse stats");
+	Json::Document doc;
+	parser.parse(s, doc);
+	parser.parse(s, doc);
+	if (parser.stats().node_allocations != 0)
+		throw std::logic_error("parse stats count nodes reused from a Document");
+	Stringify_stats stats;
+	const auto text = j.stringify(stats);
+	if (stats.bytes != text.size() || stats.string_bytes != 4 || node(stats, Json_type::Array) != 1
+		|| node(stats, Json_type::Interger) != 1 || node(stats, Json_type::Float) != 1)
+		throw std::logic_error("stringify stats");
+}
+#endif
+
+void test_keys() //a parser stores each short name once; long names and names past capacity still work
+{
+	Json::Parser parser;
+	const auto j = parser.parse(R"([{"id": 1, "name": "a"}, {"id": 2, "name": "b"}])");
+	auto& keys = parser.keys();
+	const auto before = allocations;
+	const auto id = keys.intern("id");
+	if (keys.size() != 2 || allocations != before || id.data() != keys.intern("id").data() || j[1][id] != 2)
+		throw std::logic_error("equal names of a parser are not shared");
+	const std::string long_name(Key_table::max_name_length + 1, 'x');
+	const auto k = parser.parse("{\"" + long_name + "\": 1}");
+	if (keys.size() != 2 || keys.intern(long_name).data() == keys.intern(long_name).data() || k[long_name] != 1)
+		throw std::logic_error("long names are interned");
+	std::string many = "{";
+	for (size_t i = 0; i < keys.capacity() + 10; ++i)
+		many += "\"n" + std::to_string(i) + "\": " + std::to_string(i) + ",";
+	many.back() = '}';
+	const auto m = parser.parse(many);
+	if (keys.size() != keys.capacity() || m.size() != keys.capacity() + 10 || m["n4105"] != 4105)
+		throw std::logic_error("names past the table capacity");
+}
+
+void test_binary() //cbor and msgpack read back what they write, in the smallest encoding, within the limits
+{
+	using limits = std::numeric_limits<std::int64_t>;
+	Json j = { limits::min(), limits::max(), 0, -1, 23, 24, -24, -25, 127, 128, -32, -33, -128, -129, 255, 256,
+		65535, 65536, 4294967295LL, 4294967296LL, -2147483648LL, -2147483649LL, 0.5, -1e300,
+		std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity() };
+	j.push_back({ { "empty", "" }, { "long", std::string(70000, 'x') }, { std::string(300, 'k'), true } });
+	if (Json::from_cbor(j.to_cbor()) != j || Json::from_msgpack(j.to_msgpack()) != j)
+		throw std::logic_error("binary round trip");
+	const auto nan = std::numeric_limits<double>::quiet_NaN();
+	if (!std::isnan(static_cast<double>(Json::from_cbor(Json(nan).to_cbor())))
+		|| !std::isnan(static_cast<double>(Json::from_msgpack(Json(nan).to_msgpack()))))
+		throw std::logic_error("binary NaN");
+	for (const auto& [n, bytes] : { std::pair<std::int64_t, size_t>{ 23, 1 }, { 255, 2 }, { 65535, 3 }, { 4294967295LL, 5 },
+		{ 4294967296LL, 9 } })
+	{
+		if (Json(n).to_cbor().size() != bytes || Json(n).to_msgpack().size() != (n < 128 ? 1 : bytes))
+			throw std::logic_error("binary integers are not in their smallest encoding");
+	}
+	const auto code = [](auto read)
+	{
+		try
+		{
+			read();
+		}
+		catch (const input_error& e)
+		{
+			return e.error().code;
+		}
+		return Parse_errc::None;
+	};
+	const auto nested = Json::parse("[[[1, 2, 3]]]");
+	const auto cbor = nested.to_cbor();
+	const auto msgpack = nested.to_msgpack();
+	for (const auto& [limit, expected] : { std::pair{ Parse_limits{ .max_depth = 2 }, Parse_errc::Nesting_too_deep },
+		{ Parse_limits{ .max_elements = 2 }, Parse_errc::Too_many_elements },
+		{ Parse_limits{ .max_document_size = 4 }, Parse_errc::Document_too_large } })
+	{
+		if (code([&] { Json::from_cbor(cbor, limit); }) != expected || code([&] { Json::from_msgpack(msgpack, limit); }) != expected)
+			throw std::logic_error("binary readers ignore their Parse_limits");
+	}
+	const auto text = Json::parse(R"(["abcd"])");
+	if (code([&] { Json::from_cbor(text.to_cbor(), { .max_string_length = 3 }); }) != Parse_errc::String_too_long
+		|| code([&] { Json::from_msgpack(text.to_msgpack(), { .max_string_length = 4 }); }) != Parse_errc::None)
+		throw std::logic_error("binary readers ignore max_string_length");
+}
+
+void test_schema() //both bounds of a pair apply, whichever keyword comes first
+{
+	const Json::Schema low(Json::parse(R"({"minimum": 5, "exclusiveMinimum": 3})"));
+	const Json::Schema high(Json::parse(R"({"exclusiveMaximum": 10, "maximum": 7})"));
+	if (!low.is_valid(Json(5)) || low.validate(Json(4)).code != Schema_errc::Minimum)
+		throw std::logic_error("schema minimum bounds");
+	if (!high.is_valid(Json(7)) || high.validate(Json(8)).code != Schema_errc::Maximum)
+		throw std::logic_error("schema maximum bounds");
+	const Json::Schema schema(Json::parse(R"({"type": "object", "required": ["id"],
+		"properties": {"id": {"type": "integer", "exclusiveMinimum": 0}}})"));
+	if (!schema.is_valid(Json::parse(R"({"id": 1})")))
+		throw std::logic_error("schema rejects a valid document");
+	if (const auto error = schema.validate(Json::parse(R"({"id": 0})")); error.path != "/id")
+		throw std::logic_error("schema accepts an invalid document");
+	Json::Parser parser;
+	Json j;
+	if (parser.try_parse(R"({"id": "x"})", schema, j).code != Parse_errc::Schema_mismatch
+		|| parser.schema_error().code != Schema_errc::Type || parser.try_parse(R"({"id": 2})", schema, j))
+		throw std::logic_error("schema checked parse");
+}
+
+void test_projection() //keeps exactly the selected members, and a skipped value must still be json
+{
+	const auto s = read_data("citm_catalog.json");
+	const auto full = Json::parse(s);
+	const auto j = Json::parse(s, Json::Projection{ "performances[*].id" });
+	const auto& performances = full["performances"];
+	if (j.size() != 1 || j["performances"].size() != performances.size())
+		throw std::logic_error("projection keeps the wrong members");
+	for (size_t i = 0; i < performances.size(); ++i)
+	{
+		if (j["performances"][i].size() != 1 || !(j["performances"][i]["id"] == performances[i]["id"]))
+			throw std::logic_error("projection keeps the wrong members");
+	}
+	Json::Parser parser;
+	Json root;
+	for (const auto text : { R"({"skip": [1, }, "k": 1})", R"({"skip": tru, "k": 1})", R"({"x": [1,, 2], "k": 1})",
+		R"({"x": {"a" 1}, "k": 1})", R"({"x": [1 2], "k": 1})", R"({"x": {1: 2}, "k": 1})", R"({"x": [1, 2)" })
+	{
+		const auto skipped = parser.try_parse(text, Json::Projection{ "k" }, root);
+		const auto parsed = parser.try_parse(text, root);
+		if (!skipped || skipped.code != parsed.code || skipped.offset != parsed.offset)
+			throw std::logic_error("projection skips over malformed input");
+	}
+	if (parser.try_parse(R"({"x": [1., -2.5e+3, {"a": 1,}], "k": 1})", Json::Projection{ "k" }, root) || root["k"] != 1)
+		throw std::logic_error("projection rejects what parse accepts");
+}
+
+void test_depth() //deep input fails cleanly instead of overflowing the stack
+{
+	Json root;
+	if (Json::try_parse(std::string(100000, '['), root).code != Parse_errc::Nesting_too_deep)
+		throw std::logic_error("deep input is not rejected");
+	const auto nested = [](size_t depth)
+	{
+		return "[" + std::string(depth - 1, '[') + std::string(depth - 1, ']') + ", 1]";
+	};
+	Thread_pool pool(2);
+	Json::parse_parallel(nested(1024), pool);
+	try
+	{
+		Json::parse_parallel(nested(1025), pool); //the outer '[' counts as in Json::parse
+	}
+	catch (const input_error& e)
+	{
+		if (e.error().code == Parse_errc::Nesting_too_deep)
+			return;
+	}
+	throw std::logic_error("parallel parse goes past the depth limit");
+}
+
+void test_snapshot() //a written snapshot maps back to the same document
+{
+	const auto s = read_data("citm_catalog.json");
+	const auto j = Json::parse(s);
+	j.write_snapshot("citm_catalog.jsnp");
+	const auto snapshot = Snapshot::open("citm_catalog.jsnp");
+	const auto same = Json(snapshot.root()) == j
+		&& snapshot.root()["performances"].size() == j["performances"].size();
+	std::remove("citm_catalog.jsnp");
+	if (!same)
+		throw std::logic_error("snapshot differs from the document");
+	const auto image = Json::parse(R"({"a": [1, "xyz", 2.5], "b": {"c": true, "d": null}})").to_snapshot();
+	auto truncated = image;
+	truncated.resize(image.size() - 8);
+	const std::uint64_t size = truncated.size();
+	std::memcpy(truncated.data() + offsetof(Snapshot_header, size), &size, sizeof(size));
+	try
+	{
+		Snapshot::from_buffer(truncated);
+		throw std::logic_error("a truncated snapshot opens");
+	}
+	catch (const input_error&)
+	{
+	}
+	for (size_t i = 0; i < image.size(); ++i) //any corrupt byte either fails to open or reads in bounds
+	{
+		auto corrupt = image;
+		corrupt[i] = 0xff;
+		try
+		{
+			const auto snapshot = Snapshot::from_buffer(std::move(corrupt));
+			Json copy(snapshot.root());
+		}
+		catch (const input_error&)
+		{
+		}
+	}
+}
+
+void test_async_parse() //fed in small chunks with a small budget, still the same document
+{
+	const auto s = read_data("citm_catalog.json");
+	Json::Parser parser;
+	auto task = parser.parse_async(4096);
+	for (size_t at = 0; !task.done(); task.resume())
+	{
+		if (!task.wants_input())
+			continue;
+		if (at < s.size())
+			task.feed(std::string_view(s).substr(at, 1000));
+		else
+			task.finish();
+		at += 1000;
+	}
+	if (!(task.get() == Json::parse(s)))
+		throw std::logic_error("chunked parse differs from parse");
+}
+
+void test_packed_reads() //a reference from a const read of a packed array outlives the expression
+{
+	const auto j = Json::parse("[1.5, 2.5]");
+	const Json& first = j[0];
+	const Json& last = j.at(1);
+	const double sum = static_cast<double>(first) + static_cast<double>(last);
+	if (!j.is_packed() || sum != 4.0 || &first != &j[0])
+		throw std::logic_error("const read of a packed array");
 }
 
 int main()
 {
-	test();
+	test_pool();
+	test_depth();
+	test_packed_reads();
+	test_snapshot();
+	test_parallel_stringify();
+	test_parallel_parse();
+	test_parallel_parse_errors();
+	test_parse_errors();
+	test_keys();
+	test_binary();
+#ifdef JASOON_ENABLE_STATS
+	test_stats();
+#endif
+	test_schema();
+	test_projection();
+	test_async_parse();
 	auto j = Json::parse("{ \"happy\": true, \"pi\": 3.141}"); 
 	std::cout << std::boolalpha << j["pi"].is_float() << '\n';
 	j["happy"] = false;
 	bool b = j["happy"];
 	std::cout << b << '\n';
-	auto j2 = Json::parse("data.json", InputMode::File);
+	auto j2 = Json::parse(data_file("data.json"), InputMode::File);
 	std::string s = j2["web-app"]["servlet"][0]["servlet-name"];
 	std::cout << s << std::endl;
 	std::cout << j2.stringify() << '\n';
@@ -54,7 +470,17 @@ int main()
 		} }
 	};
 	std::cout << static_cast<int>(j4["list"][1]) << '\n';
+	const auto config = R"({
+		"pi": 3.141, "happy": true, "name": "Niels", "nothing": null,
+		"answer": { "everything": 42 },
+		"list": [ 1, 0, 2 ],
+		"object": { "currency": "USD", "value": 42.99 }
+	})"_json; //the same document, parsed and laid out by the compiler
+	if (Json(config) != j4 || static_cast<int>(config["list"][2]) != 2)
+		throw std::logic_error("the _json literal differs from the same document built at run time");
 	auto j5 = j4;
-	std::cout << static_cast<int>(j5["list"][2]);
+	std::cout << static_cast<int>(j5["list"][2]) << '\n';
+	if (Json::from_cbor(j4.to_cbor()) != j4 || Json::from_msgpack(j4.to_msgpack()) != j4)
+		throw std::logic_error("binary round trip of the demo document");
 	std::cin.get();
 }
\ No newline at end of file